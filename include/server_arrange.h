@@ -10,6 +10,9 @@ void arrange_output(struct sway_output *output);
 
 void arrange_root(void);
 
+// Only arranges the outputs whose geometry or windows changed
+void arrange_changed_outputs(void);
+
 void arrange_output_layout(void);
 
 void arrange_layers(struct sway_output *output);
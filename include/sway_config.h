@@ -214,6 +214,12 @@ void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding);
  */
 void config_update_font_height(bool recalculate);
 
+/**
+ * Start measuring the default font on a startup job, so that the next config
+ * gets the right font height from the start.
+ */
+void config_prefetch_font_metrics(void);
+
 /**
  * Convert bindsym into bindcode using the first configured layout.
  * Return false in case the conversion is unsuccessful.
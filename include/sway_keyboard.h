@@ -83,6 +83,20 @@ struct sway_keyboard_group {
 struct xkb_keymap *sway_keyboard_compile_keymap(struct input_config *ic,
         char **error);
 
+/**
+ * Start compiling the keymap of keyboards without an input config on a
+ * startup job.
+ */
+void sway_keyboard_prefetch_default_keymap(void);
+
+/**
+ * Return a new reference to the keymap of keyboards without an input config.
+ * It is only compiled once, and shared by all of them.
+ */
+struct xkb_keymap *sway_keyboard_get_default_keymap(void);
+
+void sway_keyboard_release_default_keymap(void);
+
 struct sway_keyboard *sway_keyboard_create(struct sway_seat *seat,
         struct sway_seat_device *device);
 
@@ -28,5 +28,10 @@ void window_calculate_title_height(struct wls_window *window);
  */
 size_t window_titlebar_height(void);
 
+/**
+ * Add the size of the title textures to the served metrics.
+ */
+void window_title_register_metrics(void);
+
 
 #endif /* SERVER_WINDOW_TITLE_H_ */
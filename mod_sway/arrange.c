@@ -84,23 +84,40 @@ void arrange_output(struct sway_output *output) {
         node_set_dirty(&output->node);
     }
 
+    output_set_arranged(output);
 }
 
-void arrange_root(void) {
+static void arrange_layout_box(void) {
     const struct wlr_box *layout_box =
         wlr_output_layout_get_box(wls->output_manager->output_layout, NULL);
     wls->output_manager->x = layout_box->x;
     wls->output_manager->y = layout_box->y;
     wls->output_manager->width = layout_box->width;
     wls->output_manager->height = layout_box->height;
+}
+
+void arrange_root(void) {
+    arrange_layout_box();
 
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         arrange_output(output);
     }
 }
 
+static void arrange_changed_output(struct sway_output *output,
+        uint32_t changes, void *data) {
+    sway_log(SWAY_DEBUG, "Output %s changed (0x%x), rearranging it",
+        output->wlr_output->name, changes);
+    arrange_output(output);
+}
+
+void arrange_changed_outputs(void) {
+    arrange_layout_box();
+    wls_for_each_changed_output(arrange_changed_output, NULL);
+}
+
 void arrange_output_layout(void) {
-    arrange_root();
+    arrange_changed_outputs();
     transaction_commit_dirty();
 }
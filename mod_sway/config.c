@@ -20,9 +20,11 @@
 #include "input_manager.h"
 #include "foreach.h"
 #include "seat.h"
+#include "startup.h"
 #include "sway_switch.h"
 #include "sway_commands.h"
 #include "sway_config.h"
+#include "sway_keyboard.h"
 #include "transaction.h"
 #include "server_arrange.h"
 #include "server_wm.h"
@@ -37,6 +39,52 @@
 
 struct sway_config *config = NULL;
 
+#define DEFAULT_FONT "monospace 10"
+
+struct font_metrics {
+    int height, baseline;
+};
+
+// Measures DEFAULT_FONT while the backend starts, see config_defaults()
+static struct wls_startup_job *font_metrics_job = NULL;
+
+static void *measure_default_font(void *data) {
+    struct font_metrics *metrics = calloc(1, sizeof(struct font_metrics));
+    if (!metrics) {
+        return NULL;
+    }
+    // This also gets fontconfig to load its configuration and caches
+    cairo_t *cairo = cairo_create(NULL);
+    get_text_size(cairo, DEFAULT_FONT, NULL, &metrics->height,
+        &metrics->baseline, 1, false, "%s", "Hg");
+    cairo_destroy(cairo);
+    return metrics;
+}
+
+void config_prefetch_font_metrics(void) {
+    if (!font_metrics_job) {
+        font_metrics_job = wls_startup_job_start("font metrics",
+            measure_default_font, NULL);
+    }
+}
+
+/**
+ * Create the keysym translation state for the keymap, taking over the
+ * caller's reference to it.
+ */
+static struct xkb_state *keysym_translation_state_from_keymap(
+        struct xkb_keymap *keymap) {
+    if (!keymap) {
+        sway_log(SWAY_ERROR, "Unable to compile the keymap used to translate "
+            "keysyms");
+        return NULL;
+    }
+    // The state holds its own reference to the keymap
+    struct xkb_state *state = xkb_state_new(keymap);
+    xkb_keymap_unref(keymap);
+    return state;
+}
+
 static struct xkb_state *keysym_translation_state_create(
         struct xkb_rule_names rules) {
     struct xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
@@ -46,12 +94,11 @@ static struct xkb_state *keysym_translation_state_create(
         XKB_KEYMAP_COMPILE_NO_FLAGS);
 
     xkb_context_unref(context);
-    return xkb_state_new(xkb_keymap);
+    return keysym_translation_state_from_keymap(xkb_keymap);
 }
 
 static void keysym_translation_state_destroy(
         struct xkb_state *state) {
-    xkb_keymap_unref(xkb_state_get_keymap(state));
     xkb_state_unref(state);
 }
 
@@ -115,8 +162,17 @@ static void config_defaults(struct sway_config *config) {
     if (!(config->current_mode->keysym_bindings = create_list())) goto cleanup;
     if (!(config->current_mode->keycode_bindings = create_list())) goto cleanup;
 
-    if (!(config->font = strdup("monospace 10"))) goto cleanup;
+    if (!(config->font = strdup(DEFAULT_FONT))) goto cleanup;
     config->font_height = 17; // height of monospace 10
+    if (font_metrics_job) {
+        struct font_metrics *metrics = wls_startup_job_take(font_metrics_job);
+        font_metrics_job = NULL;
+        if (metrics && metrics->height > 0) {
+            config->font_height = metrics->height;
+            config->font_baseline = metrics->baseline;
+        }
+        free(metrics);
+    }
     config->urgent_timeout = 500;
     config->xwayland = XWAYLAND_MODE_LAZY;
 
@@ -160,10 +216,10 @@ static void config_defaults(struct sway_config *config) {
 
     color_to_rgba(config->border_colors.background, 0xFFFFFFFF);
 
-    // The keysym to keycode translation
-    struct xkb_rule_names rules = {0};
-    config->keysym_translation_state =
-        keysym_translation_state_create(rules);
+    // The keysym to keycode translation, with the keymap that keyboards
+    // without an input config use
+    config->keysym_translation_state = keysym_translation_state_from_keymap(
+        sway_keyboard_get_default_keymap());
 
     insert_default_keybindings();
     return;
@@ -162,6 +162,7 @@ void merge_input_config(struct input_config *dst, struct input_config *src) {
             struct input_config_tool *dst_tool = dst->tools->items[j];
             if (src_tool->type == dst_tool->type) {
                 dst_tool->mode = src_tool->mode;
+                dst_tool->coalesce_axes = src_tool->coalesce_axes;
                 goto tool_merge_outer;
             }
         }
@@ -1,3 +1,4 @@
+#define SWAY_LOG_CATEGORY SWAY_LOG_LAYER_SHELL
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,6 +8,7 @@
 #include <wlr/types/wlr_output_damage.h>
 #include <wlr/types/wlr_output.h>
 #include "log.h"
+#include "profile.h"
 #include "cursor.h"
 #include "damage.h"
 #include "transaction.h"
@@ -237,8 +239,8 @@ void arrange_layers(struct sway_output *output) {
 
 static struct sway_layer_surface *find_mapped_layer_by_client(
         struct wl_client *client, struct wlr_output *ignore_output) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         if (output->wlr_output == ignore_output) {
             continue;
         }
@@ -283,6 +285,7 @@ static void handle_output_destroy(struct wl_listener *listener, void *data) {
 }
 
 static void handle_surface_commit(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK_NAMED("layer_shell_handle_surface_commit");
     struct sway_layer_surface *layer =
         wl_container_of(listener, layer, surface_commit);
     struct wlr_layer_surface_v1 *layer_surface = layer->layer_surface;
@@ -305,6 +308,7 @@ static void handle_surface_commit(struct wl_listener *listener, void *data) {
         layer->layer = layer_surface->current.layer;
     }
     if (geo_changed || layer_changed) {
+        cursor_invalidate_all_touch_points();
         output_damage_surface(output, old_geo.x, old_geo.y,
             layer_surface->surface, true);
         output_damage_surface(output, layer->geo.x, layer->geo.y,
@@ -400,12 +404,14 @@ static void subsurface_damage(struct sway_layer_subsurface *subsurface,
 static void subsurface_handle_unmap(struct wl_listener *listener, void *data) {
     struct sway_layer_subsurface *subsurface =
             wl_container_of(listener, subsurface, unmap);
+    cursor_invalidate_all_touch_points();
     subsurface_damage(subsurface, true);
 }
 
 static void subsurface_handle_map(struct wl_listener *listener, void *data) {
     struct sway_layer_subsurface *subsurface =
             wl_container_of(listener, subsurface, map);
+    cursor_invalidate_all_touch_points();
     subsurface_damage(subsurface, true);
 }
 
@@ -496,11 +502,13 @@ static void popup_handle_map(struct wl_listener *listener, void *data) {
     struct sway_layer_surface *layer = popup_get_layer(popup);
     struct wlr_output *wlr_output = layer->layer_surface->output;
     wlr_surface_send_enter(popup->wlr_popup->base->surface, wlr_output);
+    cursor_invalidate_all_touch_points();
     popup_damage(popup, true);
 }
 
 static void popup_handle_unmap(struct wl_listener *listener, void *data) {
     struct sway_layer_popup *popup = wl_container_of(listener, popup, unmap);
+    cursor_invalidate_all_touch_points();
     popup_damage(popup, true);
 }
 
@@ -609,14 +617,14 @@ void handle_layer_shell_surface(struct wl_listener *listener, void *data) {
             output = seat_get_focused_output(seat);
         }
         if (!output || output == wls->output_manager->noop_output) {
-            if (!wls->output_manager->outputs->length) {
+            if (!wls->output_manager->outputs.length) {
                 sway_log(SWAY_ERROR,
                         "no output to auto-assign layer surface '%s' to",
                         layer_surface->namespace);
                 wlr_layer_surface_v1_close(layer_surface);
                 return;
             }
-            output = wls->output_manager->outputs->items[0];
+            output = wls->output_manager->outputs.items[0];
         }
         layer_surface->output = output->wlr_output;
     }
@@ -26,6 +26,7 @@
 #include "render.h"
 #include "sway_server.h"
 #include "server_wm.h"
+#include "surface.h"
 #include "window_title.h"
 #include "window.h"
 #include "output_manager.h"
@@ -61,6 +62,8 @@ static void render_surface_iterator(struct sway_output *output, struct sway_view
     pixman_region32_t *output_damage = data->damage;
     float alpha = data->alpha;
 
+    surface_note_rendered(surface);
+
     struct wlr_texture *texture = wlr_surface_get_texture(surface);
     if (!texture) {
         return;
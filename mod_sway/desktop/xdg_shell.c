@@ -7,6 +7,7 @@
 #include <wlr/util/edges.h>
 #include "damage.h"
 #include "log.h"
+#include "profile.h"
 #include "sway_decoration.h"
 #include "transaction.h"
 #include "input_manager.h"
@@ -269,6 +270,7 @@ static const struct sway_view_impl view_impl = {
 };
 
 static void handle_commit(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK_NAMED("xdg_shell_handle_commit");
     struct sway_xdg_shell_view *xdg_shell_view =
         wl_container_of(listener, xdg_shell_view, commit);
     struct sway_view *view = &xdg_shell_view->view;
@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 199309L
+#define SWAY_LOG_CATEGORY SWAY_LOG_XWAYLAND
 #include <float.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -8,6 +9,7 @@
 #include <wlr/xwayland.h>
 #include "damage.h"
 #include "log.h"
+#include "profile.h"
 #include "transaction.h"
 #include "input_manager.h"
 #include "seat.h"
@@ -60,6 +62,7 @@ static void unmanaged_handle_set_geometry(struct wl_listener *listener, void *da
 
     if (xsurface->x != surface->lx || xsurface->y != surface->ly) {
         // Surface has moved
+        cursor_invalidate_all_touch_points();
         desktop_damage_surface(xsurface->surface, surface->lx, surface->ly,
             true);
         surface->lx = xsurface->x;
@@ -84,6 +87,7 @@ static void unmanaged_handle_map(struct wl_listener *listener, void *data) {
 
     surface->lx = xsurface->x;
     surface->ly = xsurface->y;
+    cursor_invalidate_all_touch_points();
     desktop_damage_surface(xsurface->surface, surface->lx, surface->ly, true);
 
     if (wlr_xwayland_or_surface_wants_focus(xsurface)) {
@@ -98,6 +102,7 @@ static void unmanaged_handle_unmap(struct wl_listener *listener, void *data) {
     struct sway_xwayland_unmanaged *surface =
         wl_container_of(listener, surface, unmap);
     struct wlr_xwayland_surface *xsurface = surface->wlr_xwayland_surface;
+    cursor_invalidate_all_touch_points();
     desktop_damage_surface(xsurface->surface, xsurface->x, xsurface->y, true);
     wl_list_remove(&surface->link);
     wl_list_remove(&surface->set_geometry.link);
@@ -362,6 +367,7 @@ static void get_geometry(struct sway_view *view, struct wlr_box *box) {
 }
 
 static void handle_commit(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK_NAMED("xwayland_handle_commit");
     struct sway_xwayland_view *xwayland_view =
         wl_container_of(listener, xwayland_view, commit);
     struct sway_view *view = &xwayland_view->view;
@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_INPUT
 #include <assert.h>
 #include <math.h>
 #include <libevdev/libevdev.h>
@@ -19,7 +20,9 @@
 #include "cursor.h"
 #include "damage.h"
 #include "idle.h"
+#include "latency.h"
 #include "log.h"
+#include "profile.h"
 #include "util.h"
 #include "sway_commands.h"
 #include "sway_config.h"
@@ -35,6 +38,7 @@
 #include "wlr-layer-shell-unstable-v1-protocol.h"
 #include "wlstem.h"
 #include "server.h"
+#include "xcursor_cache.h"
 
 static struct wlr_surface *layer_surface_at(struct sway_output *output,
         struct wl_list *layer, double ox, double oy, double *sx, double *sy) {
@@ -311,12 +315,15 @@ static void pointer_motion(struct sway_cursor *cursor, uint32_t time_msec,
     }
 
     wlr_cursor_move(cursor->cursor, device, dx, dy);
+    wls_latency_note_input_at(wls_latency_source_from_device(device),
+        time_msec, cursor->cursor->x, cursor->cursor->y);
 
     seatop_pointer_motion(cursor->seat, time_msec);
 }
 
 static void handle_pointer_motion_relative(
         struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_cursor *cursor = wl_container_of(listener, cursor, motion);
     struct wlr_event_pointer_motion *e = data;
     cursor_handle_activity_from_device(cursor, e->device);
@@ -328,6 +335,7 @@ static void handle_pointer_motion_relative(
 
 static void handle_pointer_motion_absolute(
         struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_cursor *cursor =
         wl_container_of(listener, cursor, motion_absolute);
     struct wlr_event_pointer_motion_absolute *event = data;
@@ -355,6 +363,7 @@ void dispatch_cursor_button(struct sway_cursor *cursor,
 }
 
 static void handle_pointer_button(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_cursor *cursor = wl_container_of(listener, cursor, button);
     struct wlr_event_pointer_button *event = data;
 
@@ -369,6 +378,8 @@ static void handle_pointer_button(struct wl_listener *listener, void *data) {
     }
 
     cursor_handle_activity_from_device(cursor, event->device);
+    wls_latency_note_input_at(WLS_LATENCY_SOURCE_POINTER, event->time_msec,
+        cursor->cursor->x, cursor->cursor->y);
     dispatch_cursor_button(cursor, event->device,
             event->time_msec, event->button, event->state);
     transaction_commit_dirty();
@@ -380,9 +391,12 @@ void dispatch_cursor_axis(struct sway_cursor *cursor,
 }
 
 static void handle_pointer_axis(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_cursor *cursor = wl_container_of(listener, cursor, axis);
     struct wlr_event_pointer_axis *event = data;
     cursor_handle_activity_from_device(cursor, event->device);
+    wls_latency_note_input_at(WLS_LATENCY_SOURCE_POINTER, event->time_msec,
+        cursor->cursor->x, cursor->cursor->y);
     dispatch_cursor_axis(cursor, event);
     transaction_commit_dirty();
 }
@@ -392,9 +406,160 @@ static void handle_pointer_frame(struct wl_listener *listener, void *data) {
     wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
 }
 
+static void handle_touch_point_surface_destroy(struct wl_listener *listener,
+        void *data) {
+    struct sway_touch_point *point =
+        wl_container_of(listener, point, surface_destroy);
+    wl_list_remove(&point->surface_destroy.link);
+    wl_list_init(&point->surface_destroy.link);
+    point->surface = NULL;
+}
+
+static void touch_point_set_surface(struct sway_touch_point *point,
+        struct wlr_surface *surface, double surface_lx, double surface_ly) {
+    wl_list_remove(&point->surface_destroy.link);
+    point->surface = surface;
+    point->surface_lx = surface_lx;
+    point->surface_ly = surface_ly;
+    if (surface) {
+        wl_signal_add(&surface->events.destroy, &point->surface_destroy);
+    } else {
+        wl_list_init(&point->surface_destroy.link);
+    }
+}
+
+static bool touch_point_in_surface(struct sway_touch_point *point) {
+    return point->surface && wlr_surface_point_accepts_input(point->surface,
+        point->lx - point->surface_lx, point->ly - point->surface_ly);
+}
+
+/**
+ * Return the cursor's touch point with the given id. If there is none and
+ * `create` is set, an unused one is claimed. Returns NULL when no point
+ * could be found.
+ */
+static struct sway_touch_point *cursor_get_touch_point(
+        struct sway_cursor *cursor, int32_t touch_id, bool create) {
+    struct sway_touch_point *unused = NULL;
+    for (size_t i = 0; i < SWAY_CURSOR_TOUCH_POINTS_CAP; ++i) {
+        struct sway_touch_point *point = &cursor->touch_points[i];
+        if (point->active && point->touch_id == touch_id) {
+            return point;
+        }
+        if (!point->active && !unused) {
+            unused = point;
+        }
+    }
+    if (!create || !unused) {
+        return NULL;
+    }
+    unused->active = true;
+    unused->pending = false;
+    unused->touch_id = touch_id;
+    return unused;
+}
+
+static void touch_point_release(struct sway_touch_point *point) {
+    touch_point_set_surface(point, NULL, 0, 0);
+    point->active = false;
+    point->pending = false;
+}
+
+static void dispatch_touch_motion(struct sway_cursor *cursor,
+        struct wlr_input_device *device, uint32_t time_msec, int32_t touch_id,
+        double lx, double ly, struct wlr_surface *surface, double sx, double sy) {
+    struct sway_seat *seat = cursor->seat;
+    struct wlr_seat *wlr_seat = seat->wlr_seat;
+    wls->metrics.touch_motion_dispatched++;
+
+    wls_latency_note_input_at(WLS_LATENCY_SOURCE_TOUCH, time_msec, lx, ly);
+
+    if (seat->touch_id == touch_id) {
+        seat->touch_x = lx;
+        seat->touch_y = ly;
+
+        struct sway_drag_icon *drag_icon;
+        wl_list_for_each(drag_icon, &wls->output_manager->drag_icons, link) {
+            if (drag_icon->seat == seat) {
+                drag_icon_update_position(drag_icon);
+            }
+        }
+    }
+
+    if (cursor->simulating_pointer_from_touch) {
+        if (seat->touch_id == cursor->pointer_touch_id) {
+            double dx, dy;
+            dx = lx - cursor->cursor->x;
+            dy = ly - cursor->cursor->y;
+            pointer_motion(cursor, time_msec, device, dx, dy, dx, dy);
+        }
+    } else if (surface) {
+        wlr_seat_touch_notify_motion(wlr_seat, time_msec, touch_id, sx, sy);
+    }
+}
+
+static void touch_point_dispatch_motion(struct sway_cursor *cursor,
+        struct sway_touch_point *point) {
+    struct wlr_surface *surface = NULL;
+    double sx, sy;
+
+    if (touch_point_in_surface(point)) {
+        surface = point->surface;
+        sx = point->lx - point->surface_lx;
+        sy = point->ly - point->surface_ly;
+    } else {
+        wls->metrics.touch_hit_tests++;
+        node_at_coords(cursor->seat, point->lx, point->ly, &surface, &sx, &sy);
+        touch_point_set_surface(point, surface,
+            point->lx - sx, point->ly - sy);
+    }
+
+    dispatch_touch_motion(cursor, point->device, point->time_msec,
+        point->touch_id, point->lx, point->ly, surface, sx, sy);
+}
+
+/**
+ * Dispatch the pending motion of every touch point of the cursor. This must
+ * be called before handling any other touch event, so that they are
+ * delivered in order.
+ */
+static void cursor_flush_touch_motion(struct sway_cursor *cursor) {
+    if (cursor->touch_idle) {
+        wl_event_source_remove(cursor->touch_idle);
+        cursor->touch_idle = NULL;
+    }
+
+    struct wlr_input_device *device = NULL;
+    for (size_t i = 0; i < SWAY_CURSOR_TOUCH_POINTS_CAP; ++i) {
+        struct sway_touch_point *point = &cursor->touch_points[i];
+        if (!point->active || !point->pending) {
+            continue;
+        }
+        point->pending = false;
+        device = point->device;
+        touch_point_dispatch_motion(cursor, point);
+    }
+    if (!device) {
+        return;
+    }
+
+    cursor_handle_activity_from_device(cursor, device);
+    transaction_commit_dirty();
+}
+
+static void handle_touch_idle(void *data) {
+    WLS_PROFILE_CALLBACK();
+    struct sway_cursor *cursor = data;
+    // Idle sources are destroyed once dispatched
+    cursor->touch_idle = NULL;
+    cursor_flush_touch_motion(cursor);
+}
+
 static void handle_touch_down(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_cursor *cursor = wl_container_of(listener, cursor, touch_down);
     struct wlr_event_touch_down *event = data;
+    cursor_flush_touch_motion(cursor);
     cursor_handle_activity_from_device(cursor, event->device);
     cursor_hide(cursor);
 
@@ -412,6 +577,17 @@ static void handle_touch_down(struct wl_listener *listener, void *data) {
     seat->touch_x = lx;
     seat->touch_y = ly;
 
+    wls_latency_note_input_at(WLS_LATENCY_SOURCE_TOUCH, event->time_msec,
+        lx, ly);
+
+    struct sway_touch_point *point =
+        cursor_get_touch_point(cursor, event->touch_id, true);
+    if (point) {
+        point->lx = lx;
+        point->ly = ly;
+        touch_point_set_surface(point, surface, lx - sx, ly - sy);
+    }
+
     if (surface && wlr_surface_accepts_touch(wlr_seat, surface)) {
         if (seat_is_input_allowed(seat, surface)) {
             wlr_seat_touch_notify_down(wlr_seat, surface, event->time_msec,
@@ -440,10 +616,20 @@ static void handle_touch_down(struct wl_listener *listener, void *data) {
 }
 
 static void handle_touch_up(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_cursor *cursor = wl_container_of(listener, cursor, touch_up);
     struct wlr_event_touch_up *event = data;
+    cursor_flush_touch_motion(cursor);
     cursor_handle_activity_from_device(cursor, event->device);
 
+    struct sway_touch_point *point =
+        cursor_get_touch_point(cursor, event->touch_id, false);
+    if (point) {
+        wls_latency_note_input_at(WLS_LATENCY_SOURCE_TOUCH, event->time_msec,
+            point->lx, point->ly);
+        touch_point_release(point);
+    }
+
     struct wlr_seat *wlr_seat = cursor->seat->wlr_seat;
 
     if (cursor->simulating_pointer_from_touch) {
@@ -460,44 +646,44 @@ static void handle_touch_up(struct wl_listener *listener, void *data) {
 }
 
 static void handle_touch_motion(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_cursor *cursor =
         wl_container_of(listener, cursor, touch_motion);
     struct wlr_event_touch_motion *event = data;
-    cursor_handle_activity_from_device(cursor, event->device);
-
-    struct sway_seat *seat = cursor->seat;
-    struct wlr_seat *wlr_seat = seat->wlr_seat;
-    struct wlr_surface *surface = NULL;
-
-    double lx, ly;
-    wlr_cursor_absolute_to_layout_coords(cursor->cursor, event->device,
-            event->x, event->y, &lx, &ly);
-    double sx, sy;
-    node_at_coords(cursor->seat, lx, ly, &surface, &sx, &sy);
-
-    if (seat->touch_id == event->touch_id) {
-        seat->touch_x = lx;
-        seat->touch_y = ly;
-
-        struct sway_drag_icon *drag_icon;
-        wl_list_for_each(drag_icon, &wls->output_manager->drag_icons, link) {
-            if (drag_icon->seat == seat) {
-                drag_icon_update_position(drag_icon);
-            }
-        }
+    wls->metrics.touch_motion_events++;
+
+    struct sway_touch_point *point =
+        cursor_get_touch_point(cursor, event->touch_id, true);
+    if (!point) {
+        // Out of touch points, so this one can't be batched
+        cursor_flush_touch_motion(cursor);
+        cursor_handle_activity_from_device(cursor, event->device);
+
+        double lx, ly;
+        wlr_cursor_absolute_to_layout_coords(cursor->cursor, event->device,
+                event->x, event->y, &lx, &ly);
+        struct wlr_surface *surface = NULL;
+        double sx, sy;
+        wls->metrics.touch_hit_tests++;
+        node_at_coords(cursor->seat, lx, ly, &surface, &sx, &sy);
+        dispatch_touch_motion(cursor, event->device, event->time_msec,
+            event->touch_id, lx, ly, surface, sx, sy);
+        transaction_commit_dirty();
+        return;
     }
 
-    if (cursor->simulating_pointer_from_touch) {
-        if (seat->touch_id == cursor->pointer_touch_id) {
-            double dx, dy;
-            dx = lx - cursor->cursor->x;
-            dy = ly - cursor->cursor->y;
-            pointer_motion(cursor, event->time_msec, event->device, dx, dy, dx, dy);
-            transaction_commit_dirty();
+    wlr_cursor_absolute_to_layout_coords(cursor->cursor, event->device,
+            event->x, event->y, &point->lx, &point->ly);
+    point->time_msec = event->time_msec;
+    point->device = event->device;
+    point->pending = true;
+
+    if (!cursor->touch_idle) {
+        cursor->touch_idle = wl_event_loop_add_idle(
+            wls->server->wl_event_loop, handle_touch_idle, cursor);
+        if (!cursor->touch_idle) {
+            cursor_flush_touch_motion(cursor);
         }
-    } else if (surface) {
-        wlr_seat_touch_notify_motion(wlr_seat, event->time_msec,
-            event->touch_id, sx, sy);
     }
 }
 
@@ -583,59 +769,155 @@ static void handle_tablet_tool_position(struct sway_cursor *cursor,
     transaction_commit_dirty();
 }
 
-static void handle_tool_axis(struct wl_listener *listener, void *data) {
-    struct sway_cursor *cursor = wl_container_of(listener, cursor, tool_axis);
-    struct wlr_event_tablet_tool_axis *event = data;
-    cursor_handle_activity_from_device(cursor, event->device);
-
-    struct sway_tablet_tool *sway_tool = event->tool->data;
-    if (!sway_tool) {
-        sway_log(SWAY_DEBUG, "tool axis before proximity");
-        return;
-    }
+static void tablet_tool_dispatch_axes(struct sway_cursor *cursor,
+        struct sway_tablet_tool *sway_tool,
+        struct sway_tablet_tool_axes *axes) {
+    cursor_handle_activity_from_device(cursor, axes->device);
 
     handle_tablet_tool_position(cursor, sway_tool,
-        event->updated_axes & WLR_TABLET_TOOL_AXIS_X,
-        event->updated_axes & WLR_TABLET_TOOL_AXIS_Y,
-        event->x, event->y, event->dx, event->dy, event->time_msec);
+        axes->updated_axes & WLR_TABLET_TOOL_AXIS_X,
+        axes->updated_axes & WLR_TABLET_TOOL_AXIS_Y,
+        axes->x, axes->y, axes->dx, axes->dy, axes->time_msec);
+    wls_latency_note_input_at(WLS_LATENCY_SOURCE_TABLET, axes->time_msec,
+        cursor->cursor->x, cursor->cursor->y);
 
-    if (event->updated_axes & WLR_TABLET_TOOL_AXIS_PRESSURE) {
+    if (axes->updated_axes & WLR_TABLET_TOOL_AXIS_PRESSURE) {
         wlr_tablet_v2_tablet_tool_notify_pressure(
-            sway_tool->tablet_v2_tool, event->pressure);
+            sway_tool->tablet_v2_tool, axes->pressure);
     }
 
-    if (event->updated_axes & WLR_TABLET_TOOL_AXIS_DISTANCE) {
+    if (axes->updated_axes & WLR_TABLET_TOOL_AXIS_DISTANCE) {
         wlr_tablet_v2_tablet_tool_notify_distance(
-            sway_tool->tablet_v2_tool, event->distance);
+            sway_tool->tablet_v2_tool, axes->distance);
     }
 
-    if (event->updated_axes & WLR_TABLET_TOOL_AXIS_TILT_X) {
-        sway_tool->tilt_x = event->tilt_x;
+    if (axes->updated_axes & WLR_TABLET_TOOL_AXIS_TILT_X) {
+        sway_tool->tilt_x = axes->tilt_x;
     }
 
-    if (event->updated_axes & WLR_TABLET_TOOL_AXIS_TILT_Y) {
-        sway_tool->tilt_y = event->tilt_y;
+    if (axes->updated_axes & WLR_TABLET_TOOL_AXIS_TILT_Y) {
+        sway_tool->tilt_y = axes->tilt_y;
     }
 
-    if (event->updated_axes & (WLR_TABLET_TOOL_AXIS_TILT_X | WLR_TABLET_TOOL_AXIS_TILT_Y)) {
+    if (axes->updated_axes & (WLR_TABLET_TOOL_AXIS_TILT_X | WLR_TABLET_TOOL_AXIS_TILT_Y)) {
         wlr_tablet_v2_tablet_tool_notify_tilt(
             sway_tool->tablet_v2_tool,
             sway_tool->tilt_x, sway_tool->tilt_y);
     }
 
-    if (event->updated_axes & WLR_TABLET_TOOL_AXIS_ROTATION) {
+    if (axes->updated_axes & WLR_TABLET_TOOL_AXIS_ROTATION) {
         wlr_tablet_v2_tablet_tool_notify_rotation(
-            sway_tool->tablet_v2_tool, event->rotation);
+            sway_tool->tablet_v2_tool, axes->rotation);
     }
 
-    if (event->updated_axes & WLR_TABLET_TOOL_AXIS_SLIDER) {
+    if (axes->updated_axes & WLR_TABLET_TOOL_AXIS_SLIDER) {
         wlr_tablet_v2_tablet_tool_notify_slider(
-            sway_tool->tablet_v2_tool, event->slider);
+            sway_tool->tablet_v2_tool, axes->slider);
     }
 
-    if (event->updated_axes & WLR_TABLET_TOOL_AXIS_WHEEL) {
+    if (axes->updated_axes & WLR_TABLET_TOOL_AXIS_WHEEL) {
         wlr_tablet_v2_tablet_tool_notify_wheel(
-            sway_tool->tablet_v2_tool, event->wheel_delta, 0);
+            sway_tool->tablet_v2_tool, axes->wheel_delta, 0);
+    }
+}
+
+/**
+ * Merge an axis event into the tool's pending axes. Absolute values are
+ * replaced by the most recent ones, relative ones are accumulated.
+ */
+static void tablet_tool_merge_axes(struct sway_tablet_tool_axes *pending,
+        struct wlr_event_tablet_tool_axis *event) {
+    uint32_t updated = event->updated_axes;
+
+    if (updated & WLR_TABLET_TOOL_AXIS_X) {
+        pending->x = event->x;
+    }
+    if (updated & WLR_TABLET_TOOL_AXIS_Y) {
+        pending->y = event->y;
+    }
+    pending->dx += event->dx;
+    pending->dy += event->dy;
+    if (updated & WLR_TABLET_TOOL_AXIS_PRESSURE) {
+        pending->pressure = event->pressure;
+    }
+    if (updated & WLR_TABLET_TOOL_AXIS_DISTANCE) {
+        pending->distance = event->distance;
+    }
+    if (updated & WLR_TABLET_TOOL_AXIS_TILT_X) {
+        pending->tilt_x = event->tilt_x;
+    }
+    if (updated & WLR_TABLET_TOOL_AXIS_TILT_Y) {
+        pending->tilt_y = event->tilt_y;
+    }
+    if (updated & WLR_TABLET_TOOL_AXIS_ROTATION) {
+        pending->rotation = event->rotation;
+    }
+    if (updated & WLR_TABLET_TOOL_AXIS_SLIDER) {
+        pending->slider = event->slider;
+    }
+    if (updated & WLR_TABLET_TOOL_AXIS_WHEEL) {
+        pending->wheel_delta += event->wheel_delta;
+    }
+
+    pending->updated_axes |= updated;
+    pending->time_msec = event->time_msec;
+    pending->device = event->device;
+}
+
+/**
+ * Dispatch the axis updates accumulated by the tool, if any. This must be
+ * called before handling any other event of the tool, so that they are
+ * delivered in order.
+ */
+static void tablet_tool_flush_axes(struct sway_tablet_tool *sway_tool) {
+    if (sway_tool->axes_idle) {
+        wl_event_source_remove(sway_tool->axes_idle);
+        sway_tool->axes_idle = NULL;
+    }
+    if (!sway_tool->pending_axes.updated_axes) {
+        return;
+    }
+
+    struct sway_tablet_tool_axes axes = sway_tool->pending_axes;
+    memset(&sway_tool->pending_axes, 0, sizeof(sway_tool->pending_axes));
+    tablet_tool_dispatch_axes(sway_tool->seat->cursor, sway_tool, &axes);
+}
+
+static void handle_tool_axes_idle(void *data) {
+    struct sway_tablet_tool *sway_tool = data;
+    // Idle sources are destroyed once dispatched
+    sway_tool->axes_idle = NULL;
+    tablet_tool_flush_axes(sway_tool);
+}
+
+static void handle_tool_axis(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
+    struct sway_cursor *cursor = wl_container_of(listener, cursor, tool_axis);
+    struct wlr_event_tablet_tool_axis *event = data;
+
+    struct sway_tablet_tool *sway_tool = event->tool->data;
+    if (!sway_tool) {
+        cursor_handle_activity_from_device(cursor, event->device);
+        sway_log(SWAY_DEBUG, "tool axis before proximity");
+        return;
+    }
+
+    if (!sway_tool->coalesce_axes) {
+        tablet_tool_flush_axes(sway_tool);
+
+        struct sway_tablet_tool_axes axes = {0};
+        tablet_tool_merge_axes(&axes, event);
+        tablet_tool_dispatch_axes(cursor, sway_tool, &axes);
+        return;
+    }
+
+    tablet_tool_merge_axes(&sway_tool->pending_axes, event);
+    if (!sway_tool->axes_idle) {
+        sway_tool->axes_idle = wl_event_loop_add_idle(
+            wls->server->wl_event_loop, handle_tool_axes_idle, sway_tool);
+        if (!sway_tool->axes_idle) {
+            tablet_tool_flush_axes(sway_tool);
+        }
     }
 }
 
@@ -645,9 +927,16 @@ static void handle_tool_tip(struct wl_listener *listener, void *data) {
     cursor_handle_activity_from_device(cursor, event->device);
 
     struct sway_tablet_tool *sway_tool = event->tool->data;
+    if (!sway_tool) {
+        sway_log(SWAY_DEBUG, "tool tip before proximity");
+        return;
+    }
+    tablet_tool_flush_axes(sway_tool);
     struct wlr_tablet_v2_tablet *tablet_v2 = sway_tool->tablet->tablet_v2;
     struct sway_seat *seat = cursor->seat;
 
+    wls_latency_note_input_at(WLS_LATENCY_SOURCE_TABLET, event->time_msec,
+        cursor->cursor->x, cursor->cursor->y);
 
     double sx, sy;
     struct wlr_surface *surface = NULL;
@@ -712,6 +1001,7 @@ static void handle_tool_proximity(struct wl_listener *listener, void *data) {
         sway_log(SWAY_ERROR, "tablet tool not initialized");
         return;
     }
+    tablet_tool_flush_axes(sway_tool);
 
     if (event->state == WLR_TABLET_TOOL_PROXIMITY_OUT) {
         wlr_tablet_v2_tablet_tool_notify_proximity_out(sway_tool->tablet_v2_tool);
@@ -732,6 +1022,7 @@ static void handle_tool_button(struct wl_listener *listener, void *data) {
         sway_log(SWAY_DEBUG, "tool button before proximity");
         return;
     }
+    tablet_tool_flush_axes(sway_tool);
     struct wlr_tablet_v2_tablet *tablet_v2 = sway_tool->tablet->tablet_v2;
 
     double sx, sy;
@@ -975,6 +1266,12 @@ void sway_cursor_destroy(struct sway_cursor *cursor) {
     }
 
     wl_event_source_remove(cursor->hide_source);
+    if (cursor->touch_idle) {
+        wl_event_source_remove(cursor->touch_idle);
+    }
+    for (size_t i = 0; i < SWAY_CURSOR_TOUCH_POINTS_CAP; ++i) {
+        wl_list_remove(&cursor->touch_points[i].surface_destroy.link);
+    }
 
     wl_list_remove(&cursor->image_surface_destroy.link);
     wl_list_remove(&cursor->pinch_begin.link);
@@ -996,7 +1293,7 @@ void sway_cursor_destroy(struct sway_cursor *cursor) {
     wl_list_remove(&cursor->tool_button.link);
     wl_list_remove(&cursor->request_set_cursor.link);
 
-    wlr_xcursor_manager_destroy(cursor->xcursor_manager);
+    wls_xcursor_cache_release(cursor->xcursor_manager);
     wlr_cursor_destroy(cursor->cursor);
     free(cursor);
 }
@@ -1025,6 +1322,12 @@ struct sway_cursor *sway_cursor_create(struct sway_seat *seat) {
     wl_list_init(&cursor->image_surface_destroy.link);
     cursor->image_surface_destroy.notify = handle_image_surface_destroy;
 
+    for (size_t i = 0; i < SWAY_CURSOR_TOUCH_POINTS_CAP; ++i) {
+        struct sway_touch_point *point = &cursor->touch_points[i];
+        point->surface_destroy.notify = handle_touch_point_surface_destroy;
+        wl_list_init(&point->surface_destroy.link);
+    }
+
     cursor->pointer_gestures = wlr_pointer_gestures_v1_create(wls->server->wl_display);
     cursor->pinch_begin.notify = handle_pointer_pinch_begin;
     wl_signal_add(&wlr_cursor->events.pinch_begin, &cursor->pinch_begin);
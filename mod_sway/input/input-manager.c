@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_INPUT
 #include <ctype.h>
 #include <stdio.h>
 #include <string.h>
@@ -1,3 +1,4 @@
+#define SWAY_LOG_CATEGORY SWAY_LOG_INPUT
 #include <assert.h>
 #include <limits.h>
 #include <strings.h>
@@ -16,8 +17,11 @@
 #include "cursor.h"
 #include "seat.h"
 #include "log.h"
+#include "profile.h"
+#include "startup.h"
 #include "wlstem.h"
 #include "server.h"
+#include "latency.h"
 
 static struct modifier_key {
     char *name;
@@ -378,6 +382,8 @@ static void handle_key_event(struct sway_keyboard *keyboard,
     char *device_identifier = input_device_get_identifier(wlr_device);
     bool exact_identifier = wlr_device->keyboard->group != NULL;
     seat_idle_notify_activity(seat, IDLE_SOURCE_KEYBOARD);
+    output_latency_note_input(seat_get_focused_output(seat),
+        WLS_LATENCY_SOURCE_KEYBOARD, event->time_msec);
     bool input_inhibited = seat->exclusive_client != NULL;
     struct sway_keyboard_shortcuts_inhibitor *sway_inhibitor =
         keyboard_shortcuts_inhibitor_get_for_focused_surface(seat);
@@ -495,6 +501,7 @@ static void handle_key_event(struct sway_keyboard *keyboard,
 }
 
 static void handle_keyboard_key(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_keyboard *keyboard =
         wl_container_of(listener, keyboard, keyboard_key);
     handle_key_event(keyboard, data);
@@ -598,6 +605,7 @@ static void handle_modifier_event(struct sway_keyboard *keyboard) {
 
 static void handle_keyboard_modifiers(struct wl_listener *listener,
         void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_keyboard *keyboard =
         wl_container_of(listener, keyboard, keyboard_modifiers);
     handle_modifier_event(keyboard);
@@ -716,6 +724,44 @@ cleanup:
     return keymap;
 }
 
+// See sway_keyboard_get_default_keymap()
+static struct wls_startup_job *default_keymap_job = NULL;
+static struct xkb_keymap *default_keymap = NULL;
+
+static void *compile_default_keymap(void *data) {
+    return sway_keyboard_compile_keymap(NULL, NULL);
+}
+
+void sway_keyboard_prefetch_default_keymap(void) {
+    if (!default_keymap_job && !default_keymap) {
+        default_keymap_job = wls_startup_job_start("default keymap",
+            compile_default_keymap, NULL);
+    }
+}
+
+struct xkb_keymap *sway_keyboard_get_default_keymap(void) {
+    if (default_keymap_job) {
+        default_keymap = wls_startup_job_take(default_keymap_job);
+        default_keymap_job = NULL;
+    }
+    if (!default_keymap) {
+        default_keymap = sway_keyboard_compile_keymap(NULL, NULL);
+        if (!default_keymap) {
+            return NULL;
+        }
+    }
+    return xkb_keymap_ref(default_keymap);
+}
+
+void sway_keyboard_release_default_keymap(void) {
+    if (default_keymap_job) {
+        default_keymap = wls_startup_job_take(default_keymap_job);
+        default_keymap_job = NULL;
+    }
+    xkb_keymap_unref(default_keymap);
+    default_keymap = NULL;
+}
+
 static bool repeat_info_match(struct sway_keyboard *a, struct wlr_keyboard *b) {
     return a->repeat_rate == b->repeat_info.rate &&
         a->repeat_delay == b->repeat_info.delay;
@@ -908,15 +954,17 @@ void sway_keyboard_configure(struct sway_keyboard *keyboard) {
         return;
     }
 
-    struct xkb_keymap *keymap = sway_keyboard_compile_keymap(input_config, NULL);
-    if (!keymap) {
+    struct xkb_keymap *keymap = input_config ?
+        sway_keyboard_compile_keymap(input_config, NULL) :
+        sway_keyboard_get_default_keymap();
+    if (!keymap && input_config) {
         sway_log(SWAY_ERROR, "Failed to compile keymap. Attempting defaults");
-        keymap = sway_keyboard_compile_keymap(NULL, NULL);
-        if (!keymap) {
-            sway_log(SWAY_ERROR,
-                    "Failed to compile default keymap. Aborting configure");
-            return;
-        }
+        keymap = sway_keyboard_get_default_keymap();
+    }
+    if (!keymap) {
+        sway_log(SWAY_ERROR,
+                "Failed to compile default keymap. Aborting configure");
+        return;
     }
 
     bool keymap_changed = keyboard->keymap ?
@@ -1,3 +1,4 @@
+#define SWAY_LOG_CATEGORY SWAY_LOG_INPUT
 #include <float.h>
 #include <libinput.h>
 #include <limits.h>
@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_SEAT
 #include <assert.h>
 #include <linux/input-event-codes.h>
 #include <string.h>
@@ -34,6 +35,7 @@
 #include "view.h"
 #include "wlstem.h"
 #include "server.h"
+#include "xcursor_cache.h"
 
 static void seat_device_destroy(struct sway_seat_device *seat_device) {
     if (!seat_device) {
@@ -791,7 +793,7 @@ static bool xcursor_manager_is_named(const struct wlr_xcursor_manager *manager,
 }
 
 void seat_configure_xcursor(struct sway_seat *seat) {
-    unsigned cursor_size = 24;
+    unsigned cursor_size = SEAT_DEFAULT_XCURSOR_SIZE;
     const char *cursor_theme = NULL;
 
     const struct seat_config *seat_config = seat_get_config(seat);
@@ -817,14 +819,14 @@ void seat_configure_xcursor(struct sway_seat *seat) {
                     cursor_theme) ||
                 server.xwayland.xcursor_manager->size != cursor_size)) {
 
-            wlr_xcursor_manager_destroy(server.xwayland.xcursor_manager);
+            wls_xcursor_cache_release(server.xwayland.xcursor_manager);
 
             server.xwayland.xcursor_manager =
-                wlr_xcursor_manager_create(cursor_theme, cursor_size);
+                wls_xcursor_cache_acquire(cursor_theme, cursor_size);
             sway_assert(server.xwayland.xcursor_manager,
                         "Cannot create XCursor manager for theme");
 
-            wlr_xcursor_manager_load(server.xwayland.xcursor_manager, 1);
+            wls_xcursor_cache_load(server.xwayland.xcursor_manager, 1);
             struct wlr_xcursor *xcursor = wlr_xcursor_manager_get_xcursor(
                 server.xwayland.xcursor_manager, "left_ptr", 1);
             if (xcursor != NULL) {
@@ -838,27 +840,23 @@ void seat_configure_xcursor(struct sway_seat *seat) {
 #endif
     }
 
-    /* Create xcursor manager if we don't have one already, or if the
-     * theme has changed */
+    /* Borrow the shared xcursor manager if we don't have one already, or if
+     * the theme has changed */
     if (!seat->cursor->xcursor_manager ||
             !xcursor_manager_is_named(
                 seat->cursor->xcursor_manager, cursor_theme) ||
             seat->cursor->xcursor_manager->size != cursor_size) {
 
-        wlr_xcursor_manager_destroy(seat->cursor->xcursor_manager);
+        wls_xcursor_cache_release(seat->cursor->xcursor_manager);
         seat->cursor->xcursor_manager =
-            wlr_xcursor_manager_create(cursor_theme, cursor_size);
-        if (!seat->cursor->xcursor_manager) {
-            sway_log(SWAY_ERROR,
-                "Cannot create XCursor manager for theme '%s'", cursor_theme);
-        }
+            wls_xcursor_cache_acquire(cursor_theme, cursor_size);
     }
 
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *sway_output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *sway_output = wls->output_manager->outputs.items[i];
         struct wlr_output *output = sway_output->wlr_output;
         bool result =
-            wlr_xcursor_manager_load(seat->cursor->xcursor_manager,
+            wls_xcursor_cache_load(seat->cursor->xcursor_manager,
                 output->scale);
         if (!result) {
             sway_log(SWAY_ERROR,
@@ -904,6 +902,9 @@ static int handle_urgent_timeout(void *data) {
 }
 
 static void dump_focus_stack(struct sway_seat *seat) {
+    if (!sway_log_enabled(SWAY_DEBUG)) {
+        return;
+    }
     sway_log(SWAY_DEBUG, "=== focus stack dump start ===");
 
     struct sway_seat_node *seat_node;
@@ -1089,8 +1090,8 @@ void seat_set_exclusive_client(struct sway_seat *seat,
         seat->exclusive_client = client;
         // Triggers a refocus of the topmost surface layer if necessary
         // TODO: Make layer surface focus per-output based on cursor position
-        for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-            struct sway_output *output = wls->output_manager->outputs->items[i];
+        for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+            struct sway_output *output = wls->output_manager->outputs.items[i];
             arrange_layers(output);
         }
         return;
@@ -1,3 +1,4 @@
+#define SWAY_LOG_CATEGORY SWAY_LOG_INPUT
 #include "sway_config.h"
 #include "transaction.h"
 #include "sway_switch.h"
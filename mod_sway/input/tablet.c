@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_INPUT
 #include <stdlib.h>
 #include <wlr/backend/libinput.h>
 #include <wlr/types/wlr_tablet_v2.h>
@@ -85,6 +86,10 @@ static void handle_tablet_tool_destroy(struct wl_listener *listener, void *data)
     wl_list_remove(&tool->tool_destroy.link);
     wl_list_remove(&tool->set_cursor.link);
 
+    if (tool->axes_idle) {
+        wl_event_source_remove(tool->axes_idle);
+    }
+
     free(tool);
 }
 
@@ -96,6 +101,17 @@ void sway_tablet_tool_configure(struct sway_tablet *tablet,
         return;
     }
 
+    struct input_config *ic = input_device_get_config(
+        tablet->seat_device->input_device);
+    struct input_config_tool *tool_config = NULL;
+    for (int i = 0; ic && i < ic->tools->length; i++) {
+        struct input_config_tool *tc = ic->tools->items[i];
+        if (tc->type == wlr_tool->type) {
+            tool_config = tc;
+            break;
+        }
+    }
+
     switch (wlr_tool->type) {
     case WLR_TABLET_TOOL_TYPE_LENS:
     case WLR_TABLET_TOOL_TYPE_MOUSE:
@@ -103,22 +119,14 @@ void sway_tablet_tool_configure(struct sway_tablet *tablet,
         break;
     default:
         tool->mode = SWAY_TABLET_TOOL_MODE_ABSOLUTE;
-
-        struct input_config *ic = input_device_get_config(
-            tablet->seat_device->input_device);
-        if (!ic) {
-            break;
-        }
-
-        for (int i = 0; i < ic->tools->length; i++) {
-            struct input_config_tool *tool_config = ic->tools->items[i];
-            if (tool_config->type == wlr_tool->type) {
-                tool->mode = tool_config->mode;
-                break;
-            }
+        if (tool_config) {
+            tool->mode = tool_config->mode;
         }
     }
 
+    // Intermediate pen samples are only dropped on request
+    tool->coalesce_axes = tool_config && tool_config->coalesce_axes;
+
     tool->seat = tablet->seat_device->sway_seat;
     tool->tablet = tablet;
     tool->tablet_v2_tool =
@@ -1,6 +1,8 @@
 #define _POSIX_C_SOURCE 200809L
 #include <getopt.h>
+#include <limits.h>
 #include <pango/pangocairo.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -14,16 +16,23 @@
 #include <wlr/util/log.h>
 #include "sway_commands.h"
 #include "sway_config.h"
+#include "sway_keyboard.h"
 #include "sway_server.h"
 #include "transaction.h"
 #include "server_wm.h"
 #include "output_manager.h"
 #include "log.h"
+#include "metrics.h"
+#include "profile.h"
+#include "seat.h"
+#include "startup.h"
+#include "trace.h"
 #include "stringop.h"
 #include "util.h"
 #include "user_callbacks.h"
 #include "wlstem.h"
 #include "server.h"
+#include "xcursor_cache.h"
 
 static bool terminate_request = false;
 static int exit_value = 0;
@@ -45,6 +54,39 @@ void sig_handler(int signal) {
     sway_terminate(EXIT_SUCCESS);
 }
 
+static void toggle_trace(void) {
+    if (wls_trace_active()) {
+        wls_trace_stop();
+        sway_log(SWAY_INFO, "Trace stopped");
+        return;
+    }
+
+    if (wls->debug.trace_path) {
+        wls_trace_start_file(wls->debug.trace_path);
+        return;
+    }
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/sway-trace-%d.json",
+        getenv("XDG_RUNTIME_DIR"), getpid());
+    wls_trace_start_file(path);
+}
+
+static void start_metrics(void) {
+    if (wls->debug.metrics_path) {
+        wls_metrics_start(wls->debug.metrics_path);
+        return;
+    }
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/sway-metrics-%d.sock",
+        getenv("XDG_RUNTIME_DIR"), getpid());
+    wls_metrics_start(path);
+}
+
+static int handle_trace_signal(int signal, void *data) {
+    toggle_trace();
+    return 0;
+}
+
 void detect_raspi(void) {
     bool raspi = false;
     FILE *f = fopen("/sys/firmware/devicetree/base/model", "r");
@@ -184,10 +226,26 @@ void enable_debug_flag(const char *flag, struct wls_debug *debug) {
         debug->noatomic = true;
     } else if (strcmp(flag, "txn-wait") == 0) {
         debug->txn_wait = true;
+    } else if (strcmp(flag, "frame-cache") == 0) {
+        debug->frame_cache = true;
     } else if (strcmp(flag, "txn-timings") == 0) {
         debug->txn_timings = true;
     } else if (strncmp(flag, "txn-timeout=", 12) == 0) {
         debug->transaction_timeout_ms = atoi(&flag[12]);
+    } else if (strcmp(flag, "profile") == 0) {
+        debug->profile_interval_ms = 1000;
+    } else if (strncmp(flag, "profile=", 8) == 0) {
+        debug->profile_interval_ms = atoi(&flag[8]);
+    } else if (strcmp(flag, "trace") == 0) {
+        debug->trace = true;
+    } else if (strncmp(flag, "trace=", 6) == 0) {
+        debug->trace = true;
+        debug->trace_path = &flag[6];
+    } else if (strcmp(flag, "metrics") == 0) {
+        debug->metrics = true;
+    } else if (strncmp(flag, "metrics=", 8) == 0) {
+        debug->metrics = true;
+        debug->metrics_path = &flag[8];
     } else {
         sway_log(SWAY_ERROR, "Unknown debug flag: %s", flag);
     }
@@ -284,6 +342,8 @@ int main(int argc, char **argv) {
         }
     }
 
+    wls_startup_phase("early init");
+
     // Since wayland requires XDG_RUNTIME_DIR to be set, abort with just the
     // clear error message (when not running as an IPC client).
     if (!getenv("XDG_RUNTIME_DIR") && optind == argc) {
@@ -304,6 +364,22 @@ int main(int argc, char **argv) {
         sway_log_init(SWAY_ERROR, sway_terminate);
         wlr_log_init(WLR_ERROR, handle_wlr_log);
     }
+    const char *log_categories = getenv("SWAY_LOG_CATEGORIES");
+    if (log_categories && !sway_log_parse_categories(log_categories)) {
+        sway_log(SWAY_ERROR, "Invalid SWAY_LOG_CATEGORIES: %s", log_categories);
+    }
+    // SIGUSR2 toggles tracing once the event loop exists. Block it before
+    // any thread is started, so that until then it stays pending instead of
+    // terminating the compositor. The other threads block every signal.
+    sigset_t trace_signal;
+    sigemptyset(&trace_signal);
+    sigaddset(&trace_signal, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &trace_signal, NULL);
+
+    if (!sway_log_start_async()) {
+        sway_log(SWAY_ERROR, "Failed to start the log writer thread, "
+            "logging synchronously");
+    }
 
     sway_log(SWAY_INFO, "Sway version " SWAY_VERSION);
     log_kernel();
@@ -326,6 +402,12 @@ int main(int argc, char **argv) {
 
     sway_log(SWAY_INFO, "Starting sway version " SWAY_VERSION);
 
+    // These don't need the backend, so they run while it initializes. They
+    // may read the environment, so they are waited for before it is modified.
+    sway_keyboard_prefetch_default_keymap();
+    config_prefetch_font_metrics();
+    wls_xcursor_cache_prefetch(NULL, SEAT_DEFAULT_XCURSOR_SIZE, 1);
+
     struct wls_user_callbacks callbacks = {
         handle_output_commit,
         output_render_overlay,
@@ -333,16 +415,32 @@ int main(int argc, char **argv) {
         choose_absorber_output
     };
 
+    wls_startup_phase("wls_init");
     if (!wls_init(&callbacks)) {
         return 1;
     }
     wls->debug = wls_debug;
+    if (wls_debug.profile_interval_ms) {
+        wls_profile_set_enabled(true, wls_debug.profile_interval_ms);
+    }
+    // SIGUSR2 starts and stops tracing
+    wl_event_loop_add_signal(wls->server->wl_event_loop, SIGUSR2,
+        handle_trace_signal, NULL);
+    if (wls_debug.trace) {
+        toggle_trace();
+    }
+    if (wls_debug.metrics) {
+        start_metrics();
+    }
 
+    wls_startup_phase("server_init");
     if (!server_init(&server)) {
         return 1;
     }
 
+    wls_startup_wait_jobs();
     setenv("WAYLAND_DISPLAY", server.socket, true);
+    wls_startup_phase("load_main_config");
     if (!load_main_config()) {
         sway_terminate(EXIT_FAILURE);
         goto shutdown;
@@ -356,6 +454,7 @@ int main(int argc, char **argv) {
     config->active = true;
     transaction_commit_dirty();
 
+    wls_startup_phase("first frame");
     wls_server_run(wls->server, server.socket);
 
 shutdown:
@@ -370,6 +469,7 @@ shutdown:
     server_wm_destroy(server.wm);
 
     free_config(config);
+    sway_keyboard_release_default_keymap();
 
     pango_cairo_font_map_set_default(NULL);
 
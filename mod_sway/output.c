@@ -33,10 +33,10 @@ void handle_output_commit(struct sway_output *output,
 
 struct sway_output * choose_absorber_output(struct sway_output *giver) {
     struct sway_output *absorber = NULL;
-    if (wls->output_manager->outputs->length > 1) {
-        absorber = wls->output_manager->outputs->items[0];
+    if (wls->output_manager->outputs.length > 1) {
+        absorber = wls->output_manager->outputs.items[0];
         if (absorber == giver) {
-            absorber = wls->output_manager->outputs->items[1];
+            absorber = wls->output_manager->outputs.items[1];
         }
     }
     return absorber;
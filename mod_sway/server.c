@@ -37,6 +37,7 @@
 #if HAVE_XWAYLAND
 #include "sway_xwayland.h"
 #endif
+#include "startup.h"
 #include "wlstem.h"
 #include "server.h"
 
@@ -159,6 +160,7 @@ bool server_init(struct sway_server *server) {
 
 bool server_start(struct sway_server *server) {
 #if HAVE_XWAYLAND
+    wls_startup_phase("xwayland");
     if (config->xwayland != XWAYLAND_MODE_DISABLED) {
         sway_log(SWAY_DEBUG, "Initializing Xwayland (lazy=%d)",
                 config->xwayland == XWAYLAND_MODE_LAZY);
@@ -185,6 +187,7 @@ bool server_start(struct sway_server *server) {
 
     sway_log(SWAY_INFO, "Starting backend on wayland display '%s'",
             server->socket);
+    wls_startup_phase("backend start");
     if (!wlr_backend_start(wls->server->backend)) {
         sway_log(SWAY_ERROR, "Failed to start backend");
         wlr_backend_destroy(wls->server->backend);
@@ -625,6 +625,7 @@ static void view_child_handle_surface_map(struct wl_listener *listener,
     struct sway_view_child *child =
         wl_container_of(listener, child, surface_map);
     child->mapped = true;
+    cursor_invalidate_all_touch_points();
     view_child_damage(child, true);
 }
 
@@ -632,6 +633,7 @@ static void view_child_handle_surface_unmap(struct wl_listener *listener,
         void *data) {
     struct sway_view_child *child =
         wl_container_of(listener, child, surface_unmap);
+    cursor_invalidate_all_touch_points();
     view_child_damage(child, true);
     child->mapped = false;
 }
@@ -640,6 +642,7 @@ static void view_child_handle_view_unmap(struct wl_listener *listener,
         void *data) {
     struct sway_view_child *child =
         wl_container_of(listener, child, view_unmap);
+    cursor_invalidate_all_touch_points();
     view_child_damage(child, true);
     child->mapped = false;
 }
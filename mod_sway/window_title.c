@@ -17,11 +17,14 @@
 #include "output.h"
 #include "list.h"
 #include "log.h"
+#include "metrics.h"
+#include "trace.h"
 #include "view.h"
 #include "wlstem.h"
 
 static void update_title_texture(struct wls_window *win,
         struct wlr_texture **texture, struct border_colors *class) {
+    WLS_TRACE_SCOPE("update_title_texture");
     struct sway_output *output = window_get_effective_output(win);
     if (!output) {
         return;
@@ -119,3 +122,29 @@ void window_calculate_title_height(struct wls_window *window) {
 size_t window_titlebar_height(void) {
     return config->font_height + config->titlebar_v_padding * 2;
 }
+
+static void add_texture_bytes(struct wls_window *window, void *data) {
+    struct window_title *title_data = window->data;
+    size_t *bytes = data;
+    struct wlr_texture *textures[] = {
+        title_data->title_focused,
+        title_data->title_unfocused,
+        title_data->title_urgent,
+    };
+    for (size_t i = 0; i < sizeof(textures) / sizeof(*textures); ++i) {
+        if (textures[i]) {
+            *bytes += (size_t)textures[i]->width * textures[i]->height * 4;
+        }
+    }
+}
+
+static void write_title_metrics(FILE *f, void *data) {
+    size_t bytes = 0;
+    wls_output_layout_for_each_window(add_texture_bytes, &bytes);
+    wls_metrics_write_gauge(f, "sway_title_texture_bytes",
+        "Title bar textures of the windows in the layout.", bytes);
+}
+
+void window_title_register_metrics(void) {
+    wls_metrics_add_collector(write_title_metrics, NULL);
+}
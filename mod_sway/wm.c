@@ -39,12 +39,13 @@ static void wm_handle_output_connected(
         }
     }
 
-    arrange_root();
+    arrange_changed_outputs();
 }
 
 static void wm_handle_output_disconnected(
         struct wl_listener *listener, void *data) {
-    arrange_root();
+    // The windows went to another output, which is arranged as changed
+    arrange_changed_outputs();
 }
 
 static void wm_handle_output_mode_changed(
@@ -116,6 +117,8 @@ struct server_wm * server_wm_create(void) {
     wl_signal_add(&wls->events.new_window, &wm->new_window);
     wm->new_window.notify = wm_handle_new_window;
 
+    window_title_register_metrics();
+
     return wm;
 }
 
@@ -12,11 +12,38 @@
 
 #define SWAY_CURSOR_PRESSED_BUTTONS_CAP 32
 
+#define SWAY_CURSOR_TOUCH_POINTS_CAP 16
+
 #define SWAY_SCROLL_UP KEY_MAX + 1
 #define SWAY_SCROLL_DOWN KEY_MAX + 2
 #define SWAY_SCROLL_LEFT KEY_MAX + 3
 #define SWAY_SCROLL_RIGHT KEY_MAX + 4
 
+/**
+ * A touch point currently down on one of the seat's touch devices.
+ *
+ * Touch motion is batched per point and dispatched once per event loop
+ * iteration.
+ */
+struct sway_touch_point {
+    bool active;
+    int32_t touch_id;
+
+    // Most recent position, not dispatched yet if `pending` is set
+    bool pending;
+    double lx, ly;
+    uint32_t time_msec;
+    struct wlr_input_device *device;
+
+    // Surface found under the point by its last hit-test, and its position
+    // in layout coordinates. While the point stays within the surface's
+    // input region no new hit-test is done. Dropped whenever the scene
+    // changes, see cursor_invalidate_touch_points().
+    struct wlr_surface *surface;
+    double surface_lx, surface_ly;
+    struct wl_listener surface_destroy;
+};
+
 struct sway_cursor {
     struct sway_seat *seat;
     struct wlr_cursor *cursor;
@@ -55,6 +82,8 @@ struct sway_cursor {
     struct wl_listener touch_motion;
     bool simulating_pointer_from_touch;
     int32_t pointer_touch_id;
+    struct sway_touch_point touch_points[SWAY_CURSOR_TOUCH_POINTS_CAP];
+    struct wl_event_source *touch_idle;
 
     struct wl_listener tool_axis;
     struct wl_listener tool_tip;
@@ -94,6 +123,27 @@ struct sway_cursor *sway_cursor_create(struct sway_seat *seat);
  */
 void cursor_rebase(struct sway_cursor *cursor);
 void cursor_rebase_all(void);
+
+/**
+ * Rebase only the cursors which lie within `region` (in layout coordinates).
+ *
+ * This is cheaper than cursor_rebase_all() when only a part of the layout
+ * has changed, as cursors elsewhere don't need a new hit-test.
+ */
+void cursor_rebase_region(pixman_region32_t *region);
+
+/**
+ * Drop the surfaces cached by the cursor's touch points, so that their next
+ * motion is hit-tested again. Call this when the layout changes.
+ */
+void cursor_invalidate_touch_points(struct sway_cursor *cursor);
+
+/**
+ * Drop the surfaces cached by the touch points of every seat. Call this when
+ * surfaces are mapped, unmapped or moved outside of a transaction. Done by
+ * cursor_rebase_all() as well.
+ */
+void cursor_invalidate_all_touch_points(void);
 void cursor_update_image(struct sway_cursor *cursor, struct wls_transaction_node *node);
 
 void cursor_handle_activity_from_idle_source(struct sway_cursor *cursor,
@@ -0,0 +1,23 @@
+#ifndef WLSTEM_EXEC_H
+#define WLSTEM_EXEC_H
+#include <stdbool.h>
+#include <sys/types.h>
+
+typedef void (*wls_child_exit_func_t)(pid_t pid, int status, void *data);
+
+/**
+ * Run `cmd` with /bin/sh in a new session, without blocking the event loop.
+ *
+ * Returns the pid of the child, or -1 on error. The child is reaped from the
+ * event loop once it exits, at which point `on_exit` (if not NULL) is called
+ * with its waitpid() status.
+ */
+pid_t wls_spawn(const char *cmd, wls_child_exit_func_t on_exit, void *data);
+
+/**
+ * Stop tracking the children still running; they will not be reaped by us
+ * anymore and their exit callbacks won't be called.
+ */
+void wls_spawn_fini(void);
+
+#endif
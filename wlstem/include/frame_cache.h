@@ -0,0 +1,56 @@
+#ifndef WLSTEM_FRAME_CACHE_H_
+#define WLSTEM_FRAME_CACHE_H_
+#include <stdbool.h>
+#include <pixman.h>
+#include <wlr/render/wlr_texture.h>
+
+struct sway_output;
+
+/**
+ * Copy of the composited scene of an output, without the software cursors.
+ *
+ * Every full frame copies the region it redrew into the cache. When the only
+ * damage since the last frame comes from software cursors, the damaged
+ * region is then redrawn from the cache instead of from the whole scene.
+ * The scene is considered damaged by anything going through damage.h.
+ *
+ * The cache is off unless enabled with `-D frame-cache`. Only untransformed
+ * outputs are cached. If the GL implementation can't copy from the output's
+ * framebuffer, caching is disabled for the output.
+ */
+struct wls_output_frame_cache {
+    struct wlr_texture *texture;
+    int width, height; // in buffer pixels
+    float scale;
+    bool valid;        // the texture holds the whole scene
+    bool failed;
+};
+
+/**
+ * Return whether the current frame can be drawn from the cache.
+ */
+bool output_frame_cache_usable(struct sway_output *output);
+
+/**
+ * Called before a full frame. Extends `damage` to the whole output if the
+ * cache needs to be filled.
+ */
+void output_frame_cache_prepare(struct sway_output *output,
+        pixman_region32_t *damage);
+
+/**
+ * Copy the freshly drawn `damage` of the scene to the cache. Must be called
+ * between wlr_renderer_begin() and the rendering of software cursors.
+ */
+void output_frame_cache_update(struct sway_output *output,
+        pixman_region32_t *damage);
+
+/**
+ * Redraw `damage` from the cache.
+ */
+void output_frame_cache_render(struct sway_output *output,
+        pixman_region32_t *damage);
+
+void output_frame_cache_finish(struct sway_output *output);
+
+#endif /* WLSTEM_FRAME_CACHE_H_ */
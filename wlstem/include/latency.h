@@ -0,0 +1,132 @@
+#ifndef WLSTEM_LATENCY_H_
+#define WLSTEM_LATENCY_H_
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+struct sway_output;
+struct wlr_input_device;
+
+/**
+ * Input-to-photon latency tracing.
+ *
+ * Input handlers report the timestamp of the events they process against the
+ * output they affect. The oldest such event is then tied to the next frame
+ * committed on that output, and to its presentation, so that we get the
+ * input->commit, commit->present and input->present deltas.
+ *
+ * Input timestamps are expected to be in milliseconds of CLOCK_MONOTONIC,
+ * as provided by libinput. Deltas that don't make sense (negative, or too
+ * large to be real) are dropped, since nested backends may use other clocks.
+ *
+ * The first damage of the scene after a frame, usually caused by a client
+ * commit, is traced the same way to get the damage->present delta, split by
+ * whether adaptive sync was active.
+ */
+
+enum wls_latency_source {
+    WLS_LATENCY_SOURCE_POINTER,
+    WLS_LATENCY_SOURCE_KEYBOARD,
+    WLS_LATENCY_SOURCE_TOUCH,
+    WLS_LATENCY_SOURCE_TABLET,
+    WLS_LATENCY_SOURCE_COUNT,
+};
+
+enum wls_latency_stage {
+    WLS_LATENCY_INPUT_TO_COMMIT,
+    WLS_LATENCY_COMMIT_TO_PRESENT,
+    WLS_LATENCY_INPUT_TO_PRESENT,
+    WLS_LATENCY_STAGE_COUNT,
+};
+
+// Bucket i counts the samples below (WLS_LATENCY_BUCKET_BASE_USEC << i)
+// microseconds; the last bucket counts everything else.
+#define WLS_LATENCY_BUCKET_BASE_USEC 250
+#define WLS_LATENCY_BUCKETS 14
+
+struct wls_latency_histogram {
+    uint64_t buckets[WLS_LATENCY_BUCKETS];
+    uint64_t count;
+    uint64_t sum_usec;
+    uint64_t max_usec;
+};
+
+struct wls_output_latency {
+    // Oldest input event, per source, not yet part of a committed frame
+    bool input_pending[WLS_LATENCY_SOURCE_COUNT];
+    uint32_t input_msec[WLS_LATENCY_SOURCE_COUNT];
+
+    // Input events of the last committed frame, waiting for its presentation
+    bool commit_pending[WLS_LATENCY_SOURCE_COUNT];
+    uint32_t commit_input_msec[WLS_LATENCY_SOURCE_COUNT];
+    struct timespec commit_time;
+    uint32_t commit_seq;
+
+    // Same for the first damage of the scene, in the presentation clock
+    bool damage_pending;
+    struct timespec damage_time;
+    bool commit_damage_pending;
+    struct timespec commit_damage_time;
+    bool commit_adaptive_sync;
+
+    struct wls_latency_histogram
+        histograms[WLS_LATENCY_SOURCE_COUNT][WLS_LATENCY_STAGE_COUNT];
+};
+
+const char *wls_latency_source_name(enum wls_latency_source source);
+
+/**
+ * Return the latency source matching the device type, or
+ * WLS_LATENCY_SOURCE_COUNT if the device isn't traced.
+ */
+enum wls_latency_source wls_latency_source_from_device(
+        struct wlr_input_device *device);
+
+const char *wls_latency_stage_name(enum wls_latency_stage stage);
+
+/**
+ * Record that an input event with the given timestamp affected the output.
+ */
+void output_latency_note_input(struct sway_output *output,
+        enum wls_latency_source source, uint32_t time_msec);
+
+/**
+ * Same as output_latency_note_input(), using the output at the given layout
+ * coordinates, if any.
+ */
+void wls_latency_note_input_at(enum wls_latency_source source,
+        uint32_t time_msec, double lx, double ly);
+
+/**
+ * Record that the scene shown on the output was damaged.
+ */
+void output_latency_note_damage(struct sway_output *output);
+
+/**
+ * Called once a frame has been committed on the output.
+ */
+void output_latency_handle_commit(struct sway_output *output);
+
+/**
+ * Called once the frame with the given commit sequence number has been
+ * presented, at time `when` of the presentation clock.
+ */
+void output_latency_handle_present(struct sway_output *output,
+        uint32_t commit_seq, const struct timespec *when);
+
+/**
+ * Add a sample, in microseconds. Samples that can't be real (negative, or
+ * above 10s) are dropped.
+ */
+void wls_latency_histogram_add(struct wls_latency_histogram *histogram,
+        int64_t usec);
+
+/**
+ * Return the approximate value below which the `percentile` (0-100) of the
+ * samples of the histogram lie, in microseconds. Returns 0 if there are no
+ * samples.
+ */
+uint64_t wls_latency_histogram_percentile(
+        const struct wls_latency_histogram *histogram, double percentile);
+
+#endif /* WLSTEM_LATENCY_H_ */
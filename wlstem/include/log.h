@@ -20,16 +20,79 @@ typedef enum {
 #define ATTRIB_PRINTF(start, end)
 #endif
 
+enum sway_log_category {
+    SWAY_LOG_GENERAL = 0,
+    SWAY_LOG_TRANSACTION,
+    SWAY_LOG_DAMAGE,
+    SWAY_LOG_OUTPUT,
+    SWAY_LOG_INPUT,
+    SWAY_LOG_SEAT,
+    SWAY_LOG_XWAYLAND,
+    SWAY_LOG_LAYER_SHELL,
+    SWAY_LOG_CATEGORY_LAST,
+};
+
+// Category of the sway_log() calls of a source file. To change it, define it
+// before including anything.
+#ifndef SWAY_LOG_CATEGORY
+#define SWAY_LOG_CATEGORY SWAY_LOG_GENERAL
+#endif
+
+// Messages less important than this are compiled out of sway_log() calls
+#ifndef SWAY_LOG_MAX_IMPORTANCE
+#define SWAY_LOG_MAX_IMPORTANCE SWAY_DEBUG
+#endif
+
+// Current runtime verbosity of each category, only to be read through
+// sway_log_category_enabled()
+extern sway_log_importance_t _sway_log_importance[SWAY_LOG_CATEGORY_LAST];
+
+#define sway_log_category_enabled(cat, verb) \
+    ((verb) <= SWAY_LOG_MAX_IMPORTANCE && (verb) <= _sway_log_importance[cat])
+
+#define sway_log_enabled(verb) \
+    sway_log_category_enabled(SWAY_LOG_CATEGORY, verb)
+
 void error_handler(int sig);
 
 typedef void (*terminate_callback_t)(int exit_code);
 
-// Will log all messages less than or equal to `verbosity`
+// Will log all messages less than or equal to `verbosity`, in all categories
 // The `terminate` callback is called by `sway_abort`
 void sway_log_init(sway_log_importance_t verbosity, terminate_callback_t terminate);
 
+// Change the verbosity of a single category, can be called at any time
+void sway_log_set_category_importance(enum sway_log_category category,
+    sway_log_importance_t verbosity);
+sway_log_importance_t sway_log_get_category_importance(
+    enum sway_log_category category);
+
+const char *sway_log_category_name(enum sway_log_category category);
+
+// Apply a comma-separated list of `category=level` pairs, e.g.
+// "transaction=debug,seat=error". `*` stands for all categories, and levels
+// are silent, error, info or debug. Returns false if any pair is invalid, in
+// which case the valid ones are still applied.
+bool sway_log_parse_categories(const char *spec);
+
+// Hand formatted lines over to a writer thread instead of writing them to
+// stderr from the calling thread. Only messages logged from the thread calling
+// this function go through the writer thread. The ring is flushed on
+// sway_abort, failed assertions and exit, and written out as they are on
+// fatal signals (SIGABRT, SIGSEGV...). When it is full, lines are dropped and
+// counted.
+bool sway_log_start_async(void);
+void sway_log_stop_async(void);
+
+// Wait (briefly) for the writer thread to write out pending lines
+void sway_log_flush(void);
+
 void _sway_log(sway_log_importance_t verbosity, const char *format, ...) ATTRIB_PRINTF(2, 3);
 void _sway_vlog(sway_log_importance_t verbosity, const char *format, va_list args) ATTRIB_PRINTF(2, 0);
+void _sway_log_category(enum sway_log_category category,
+    sway_log_importance_t verbosity, const char *format, ...) ATTRIB_PRINTF(3, 4);
+void _sway_vlog_category(enum sway_log_category category,
+    sway_log_importance_t verbosity, const char *format, va_list args) ATTRIB_PRINTF(3, 0);
 void _sway_abort(const char *filename, ...) ATTRIB_PRINTF(1, 2);
 bool _sway_assert(bool condition, const char* format, ...) ATTRIB_PRINTF(2, 3);
 
@@ -40,11 +103,25 @@ bool _sway_assert(bool condition, const char* format, ...) ATTRIB_PRINTF(2, 3);
 #define _SWAY_FILENAME __FILE__
 #endif
 
+// Arguments are only evaluated if the message is going to be logged
+#define sway_log_cat(cat, verb, fmt, ...) \
+    do { \
+        if (sway_log_category_enabled(cat, verb)) { \
+            _sway_log_category(cat, verb, "[%s:%d] " fmt, _SWAY_FILENAME, \
+                __LINE__, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
 #define sway_log(verb, fmt, ...) \
-    _sway_log(verb, "[%s:%d] " fmt, _SWAY_FILENAME, __LINE__, ##__VA_ARGS__)
+    sway_log_cat(SWAY_LOG_CATEGORY, verb, fmt, ##__VA_ARGS__)
 
 #define sway_vlog(verb, fmt, args) \
-    _sway_vlog(verb, "[%s:%d] " fmt, _SWAY_FILENAME, __LINE__, args)
+    do { \
+        if (sway_log_enabled(verb)) { \
+            _sway_vlog_category(SWAY_LOG_CATEGORY, verb, "[%s:%d] " fmt, \
+                _SWAY_FILENAME, __LINE__, args); \
+        } \
+    } while (0)
 
 #define sway_log_errno(verb, fmt, ...) \
     sway_log(verb, fmt ": %s", ##__VA_ARGS__, strerror(errno))
@@ -18,7 +18,8 @@ struct loop_timer;
 struct loop *loop_create(void);
 
 /**
- * Destroy the event loop (eg. on program termination).
+ * Destroy the event loop (eg. on program termination). Timers which didn't
+ * expire yet are freed.
  */
 void loop_destroy(struct loop *loop);
 
@@ -28,7 +29,8 @@ void loop_destroy(struct loop *loop);
 void loop_poll(struct loop *loop);
 
 /**
- * Add a file descriptor to the loop.
+ * Add a file descriptor to the loop. `mask` and the mask passed to `func` are
+ * poll(2) events.
  */
 void loop_add_fd(struct loop *loop, int fd, short mask,
         void (*func)(int fd, short mask, void *data), void *data);
@@ -36,7 +38,10 @@ void loop_add_fd(struct loop *loop, int fd, short mask,
 /**
  * Add a timer to the loop.
  *
- * When the timer expires, the timer will be removed from the loop and freed.
+ * When the timer expires, it is taken out of the loop and its callback is
+ * called. The returned handle stays valid until it is passed to
+ * loop_remove_timer(), which must be done once for every timer, expired or
+ * not.
  */
 struct loop_timer *loop_add_timer(struct loop *loop, int ms,
         void (*callback)(void *data), void *data);
@@ -47,7 +52,8 @@ struct loop_timer *loop_add_timer(struct loop *loop, int ms,
 bool loop_remove_fd(struct loop *loop, int fd);
 
 /**
- * Remove a timer from the loop.
+ * Remove a timer from the loop and free it. Returns false if the timer
+ * already expired, including from its own callback.
  */
 bool loop_remove_timer(struct loop *loop, struct loop_timer *timer);
 
@@ -0,0 +1,117 @@
+#ifndef WLSTEM_METRICS_H
+#define WLSTEM_METRICS_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <wayland-server-core.h>
+#include "latency.h"
+
+/**
+ * Compositor health counters.
+ *
+ * The counters are always kept up to date, it only costs a few increments per
+ * frame. wls_metrics_start() additionally serves them in the Prometheus text
+ * format on a Unix socket, driven by the event loop. Any request gets the
+ * current values, so that they can be scraped with e.g.
+ *
+ *   curl --unix-socket $XDG_RUNTIME_DIR/sway-metrics-<pid>.sock http://x/
+ */
+
+struct wls_output_metrics {
+    uint64_t frames_rendered;
+    uint64_t frames_skipped;  // frame events without anything to render
+    uint64_t frames_missed;   // frames presented after their deadline
+    uint64_t frames_cursor_only; // redrawn from the frame cache
+    uint64_t damage_pixels;   // total over the rendered frames
+    uint64_t frame_done_throttled;
+    uint64_t surfaces_throttled; // in the last frame
+    struct wls_latency_histogram render_time;
+    // Indexed by whether adaptive sync was active
+    struct wls_latency_histogram frame_interval[2]; // between presentations
+    struct wls_latency_histogram damage_to_present[2];
+};
+
+struct wls_metrics {
+    uint64_t transactions_committed;
+    uint64_t transaction_timeouts;
+    uint64_t transaction_nodes;
+    // Dirty nodes left out of transactions because their state didn't change
+    uint64_t transaction_nodes_skipped;
+    struct wls_latency_histogram transaction_time; // commit to apply
+
+    uint64_t input_events[WLS_LATENCY_SOURCE_COUNT];
+    // Touch motion events received, motions sent to clients once batched, and
+    // the hit-tests they needed
+    uint64_t touch_motion_events;
+    uint64_t touch_motion_dispatched;
+    uint64_t touch_hit_tests;
+
+    // Output commits made to apply a configuration, and their total duration
+    uint64_t modesets;
+    uint64_t modeset_usec;
+
+    // Client buffers kept locked to render views during transactions
+    uint64_t saved_buffer_bytes;
+
+    struct wl_list clients;    // wls_client_metrics::link
+    struct wl_list collectors; // wls_metrics_collector::link
+};
+
+struct wls_client_metrics {
+    struct wl_client *client;
+    pid_t pid;
+    char comm[32];
+    uint64_t commits;
+    // Commits meant for a predicted output repaint, and those that came late
+    uint64_t frame_slots, frame_slots_missed;
+    struct wl_listener destroy;
+    struct wl_list link; // wls_metrics::clients
+};
+
+/**
+ * Collectors let the compositor add its own values to the served metrics,
+ * with wls_metrics_write_gauge().
+ */
+typedef void (*wls_metrics_collector_func_t)(FILE *f, void *data);
+
+void wls_metrics_init(struct wls_metrics *metrics);
+
+void wls_metrics_finish(struct wls_metrics *metrics);
+
+/**
+ * Count a surface commit from the client.
+ */
+void wls_metrics_note_commit(struct wl_client *client);
+
+/**
+ * Count a commit made in response to a delayed frame done, and whether it
+ * came too late for the repaint it was meant for.
+ */
+void wls_metrics_note_frame_slot(struct wl_client *client, bool missed);
+
+void wls_metrics_add_collector(wls_metrics_collector_func_t func, void *data);
+
+/**
+ * Write a gauge without labels, with its HELP and TYPE lines.
+ */
+void wls_metrics_write_gauge(FILE *f, const char *name, const char *help,
+        double value);
+
+/**
+ * Write all the metrics to `f`, in the Prometheus text format.
+ */
+void wls_metrics_write(FILE *f);
+
+/**
+ * Start serving the metrics on a Unix socket at `path`, replacing any stale
+ * socket there. Returns false on error.
+ */
+bool wls_metrics_start(const char *path);
+
+/**
+ * Stop serving the metrics, closing open connections and removing the socket.
+ */
+void wls_metrics_stop(void);
+
+#endif
@@ -2,6 +2,7 @@
 #define _SWAY_NODE_H
 #include <stdbool.h>
 #include "list.h"
+#include "vec.h"
 
 #define MIN_SANE_W 100
 #define MIN_SANE_H 60
@@ -11,6 +12,8 @@ struct wls_window;
 struct sway_transaction_instruction;
 struct wlr_box;
 
+WLS_VEC_DEFINE(wls_node_vec, struct wls_transaction_node *)
+
 enum wls_transaction_node_type {
     N_OUTPUT,
     N_WINDOW,
@@ -43,7 +46,7 @@ struct wls_transaction_node {
 
 struct wls_node_manager {
     list_t *transactions;
-    list_t *dirty_nodes;
+    struct wls_node_vec dirty_nodes;
     struct {
         struct wl_signal new_node;
     } events;
@@ -8,12 +8,32 @@
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_output_layout.h>
 #include "config.h"
+#include "frame_cache.h"
+#include "latency.h"
+#include "metrics.h"
+#include "render_timing.h"
 #include "output_config.h"
 #include "node.h"
 
 struct wls_window;
 struct sway_view;
 
+/**
+ * What changed on an output since it was last arranged, so that window
+ * managers can re-arrange only the outputs that need it, e.g. leave the
+ * windows of a laptop panel alone when a projector is plugged in.
+ */
+enum wls_output_changes {
+    WLS_OUTPUT_CHANGED_POSITION = 1 << 0, // in the output layout
+    WLS_OUTPUT_CHANGED_SIZE = 1 << 1,
+    WLS_OUTPUT_CHANGED_USABLE_AREA = 1 << 2,
+    WLS_OUTPUT_CHANGED_WINDOWS = 1 << 3, // windows added or removed
+    WLS_OUTPUT_CHANGED_ALL = (1 << 4) - 1,
+};
+
+typedef void (*wls_output_changes_func_t)(struct sway_output *output,
+        uint32_t changes, void *data);
+
 struct sway_output_state {
     bool active;
     list_t *windows;             // struct wls_window
@@ -24,6 +44,7 @@ struct sway_output {
     struct wls_transaction_node node;
     struct wlr_output *wlr_output;
     struct wl_list link;
+    char identifier[128]; // "make model serial"
 
     struct wl_list layers[4]; // sway_layer_surface::link
     struct wlr_box usable_area;
@@ -40,12 +61,21 @@ struct sway_output {
     enum scale_filter_mode scale_filter;
     // last applied mode when the output is DPMS'ed
     struct wlr_output_mode *current_mode;
+    // Effective config from wls->output_configs, see find_output_config()
+    struct output_config *config;
+    uint32_t config_generation;
 
     bool enabling, enabled;
+    int outputs_index; // in wls_output_manager::outputs
     bool active;
 
     struct sway_output_state current;
 
+    // Geometry as of the last output_set_arranged(), and other changes since
+    bool arranged;
+    struct wlr_box arranged_box, arranged_usable_area;
+    uint32_t changes; // enum wls_output_changes
+
     struct wl_listener destroy;
     struct wl_listener commit;
     struct wl_listener mode;
@@ -59,8 +89,20 @@ struct sway_output {
 
     struct timespec last_presentation;
     uint32_t refresh_nsec;
-    int max_render_time; // In milliseconds
+    int max_render_time; // In milliseconds, unless render_timing.automatic
+    bool auto_frame_delay; // Delay frame done from client commit timing
+    // Milliseconds between frame done events for surfaces that weren't
+    // drawn in the last frame, 0 to treat them like the others
+    int occluded_frame_interval;
+    uint64_t windows_render_nsec; // start of the last frame drawing windows
+    // Damage since the last frame didn't only come from software cursors
+    bool scene_damaged;
+    struct wls_output_frame_cache frame_cache;
+    struct wls_output_render_timing render_timing;
     struct wl_event_source *repaint_timer;
+
+    struct wls_output_latency latency;
+    struct wls_output_metrics metrics;
 };
 
 struct sway_output *output_create(struct wlr_output *wlr_output);
@@ -86,11 +128,34 @@ void output_disable(struct sway_output *output);
 
 bool output_has_opaque_overlay_layer_surface(struct sway_output *output);
 
+/**
+ * Return whether the output refreshes when a frame is committed rather than
+ * at a fixed rate.
+ */
+bool output_adaptive_sync_active(struct sway_output *output);
+
 void output_render(struct sway_output *output, struct timespec *when,
     pixman_region32_t *damage);
 
 void output_get_box(struct sway_output *output, struct wlr_box *box);
 
+/**
+ * Return the mask of enum wls_output_changes since the output was last
+ * arranged. Outputs never arranged have changed in every way.
+ */
+uint32_t output_get_changes(struct sway_output *output);
+
+/**
+ * Record the current geometry of the output as arranged, and clear its
+ * changes. To be called by the window manager once it arranged the output.
+ */
+void output_set_arranged(struct sway_output *output);
+
+/**
+ * Call `func` for each enabled output with changes, see output_get_changes().
+ */
+void wls_for_each_changed_output(wls_output_changes_func_t func, void *data);
+
 void output_get_render_box(struct sway_output *output, struct wlr_box *box);
 
 // _box.x and .y are expected to be layout-local
@@ -18,6 +18,11 @@ enum scale_filter_mode {
     SCALE_FILTER_SMART,
 };
 
+// Derive max_render_time from the measured render times, the default
+#define MAX_RENDER_TIME_AUTO -2
+
+#define DEFAULT_OCCLUDED_FRAME_INTERVAL 1000
+
 /**
  * Size and position configuration for a particular output.
  *
@@ -34,8 +39,10 @@ struct output_config {
     enum scale_filter_mode scale_filter;
     int32_t transform;
     enum wl_output_subpixel subpixel;
-    int max_render_time; // In milliseconds
+    int max_render_time; // In milliseconds, or MAX_RENDER_TIME_AUTO
     int adaptive_sync;
+    int auto_frame_delay;
+    int occluded_frame_interval; // In milliseconds
 
     char *background;
     char *background_option;
@@ -45,6 +52,7 @@ struct output_config {
 
 int output_name_cmp(const void *item, const void *data);
 
+// Outputs cache theirs in sway_output::identifier
 void output_get_identifier(char *identifier, size_t len,
     struct sway_output *output);
 
@@ -58,8 +66,19 @@ bool apply_output_config(struct output_config *oc, struct sway_output *output);
 
 bool test_output_config(struct output_config *oc, struct sway_output *output);
 
+/**
+ * Return a new config that would bring the output back to its current
+ * state, mode and position included.
+ */
+struct output_config *current_output_config(struct sway_output *output);
+
 struct output_config *store_output_config(struct output_config *oc);
 
+/**
+ * Return a copy of the effective config of the output, merged from the
+ * stored configs matching its name and identifier, or NULL if there is none.
+ * The merge is cached on the output until a config is stored.
+ */
 struct output_config *find_output_config(struct sway_output *output);
 
 void free_output_config(struct output_config *oc);
@@ -6,9 +6,14 @@
 #include <wlr/render/wlr_texture.h>
 #include "config.h"
 #include "list.h"
+#include "output.h"
+#include "vec.h"
 #include "window.h"
 
 struct wls_server;
+struct wls_output_head_state;
+
+WLS_VEC_DEFINE_INDEXED(wls_output_index, struct sway_output *, outputs_index)
 
 struct wls_output_manager {
     struct wlr_output_layout *output_layout;
@@ -27,9 +32,14 @@ struct wls_output_manager {
     struct wlr_output_manager_v1 *output_manager_v1;
     struct wl_listener output_manager_apply;
     struct wl_listener output_manager_test;
+    // Pending update of the configuration sent to output management clients
+    struct wl_event_source *config_idle;
+    // What was last sent, to skip updates that wouldn't change anything
+    struct wls_output_head_state *sent_heads;
+    int sent_heads_length;
 
     struct wl_listener new_output;
-    list_t *outputs; // struct sway_output
+    struct wls_output_index outputs; // enabled outputs, in no set order
 
     // For when there's no connected outputs
     struct sway_output *noop_output;
@@ -50,6 +60,11 @@ void wls_output_manager_destroy(struct wls_output_manager *output_manager);
 
 void wls_output_layout_get_box(struct wls_output_manager *output_manager, struct wlr_box *box);
 
+/**
+ * Schedule an update of the configuration sent to output management clients.
+ * Updates requested within one event loop iteration are sent together, and
+ * only if the configuration changed.
+ */
 void wls_update_output_manager_config(struct wls_output_manager *output_manager);
 
 #endif
@@ -0,0 +1,102 @@
+#ifndef WLSTEM_PROFILE_H
+#define WLSTEM_PROFILE_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <wayland-util.h>
+#include "trace.h"
+
+/**
+ * Event loop callback profiler.
+ *
+ * Listener and timer callbacks opt in by starting with WLS_PROFILE_CALLBACK().
+ * While profiling is enabled, each invocation's wall time is measured with
+ * CLOCK_MONOTONIC_RAW and accounted to a statically allocated site, so that
+ * nothing is allocated per event. While it is disabled, the cost is a load and
+ * a branch.
+ *
+ * While tracing is enabled, profiled callbacks are also written as spans.
+ */
+
+// Bucket i counts the invocations which took less than (1us << i)
+#define WLS_PROFILE_BUCKETS 16
+
+struct wls_profile_site {
+    const char *name;
+    bool registered;
+    struct wl_list link; // wls_profile::sites
+
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[WLS_PROFILE_BUCKETS];
+
+    // Totals at the beginning of the current and of the last complete window
+    uint64_t window_count, window_ns;
+    uint64_t last_count, last_ns;
+};
+
+struct wls_profile_entry {
+    const char *name;
+    uint64_t count;    // invocations during the last window
+    uint64_t total_ns; // time spent during the last window
+    uint64_t max_ns;   // worst invocation since profiling was enabled
+};
+
+extern bool _wls_profile_enabled;
+
+uint64_t wls_profile_begin(struct wls_profile_site *site);
+void wls_profile_end(struct wls_profile_site *site, uint64_t start_ns);
+
+struct wls_profile_scope {
+    struct wls_profile_site *site;
+    uint64_t start_ns;
+};
+
+static inline void wls_profile_scope_end(struct wls_profile_scope *scope) {
+    if (scope->start_ns) {
+        wls_profile_end(scope->site, scope->start_ns);
+    }
+}
+
+/**
+ * Profile the enclosing function until it returns, under the given name.
+ */
+#define WLS_PROFILE_CALLBACK_NAMED(site_name) \
+    static struct wls_profile_site _wls_profile_site = { .name = site_name }; \
+    struct wls_profile_scope _wls_profile_scope \
+        __attribute__((cleanup(wls_profile_scope_end))) = { \
+            .site = &_wls_profile_site, \
+            .start_ns = _wls_profile_enabled || _wls_trace_enabled ? \
+                wls_profile_begin(&_wls_profile_site) : 0, \
+        }
+
+/**
+ * Profile the enclosing function until it returns.
+ */
+#define WLS_PROFILE_CALLBACK() WLS_PROFILE_CALLBACK_NAMED(__func__)
+
+/**
+ * Enable or disable profiling. While enabled, the top callbacks of each
+ * `interval_ms` window are logged; 0 disables the periodic summary.
+ */
+void wls_profile_set_enabled(bool enabled, uint32_t interval_ms);
+
+/**
+ * Fill `entries` with up to `max` callbacks which took the most time during
+ * the last complete window, worst first. Returns the number of entries.
+ */
+size_t wls_profile_top(struct wls_profile_entry *entries, size_t max);
+
+/**
+ * Close the current window. Called by the summary timer, or manually when
+ * the periodic summary is disabled.
+ */
+void wls_profile_rotate(void);
+
+/**
+ * Clear the accumulated statistics.
+ */
+void wls_profile_reset(void);
+
+#endif
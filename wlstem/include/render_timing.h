@@ -0,0 +1,88 @@
+#ifndef WLSTEM_RENDER_TIMING_H_
+#define WLSTEM_RENDER_TIMING_H_
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+struct sway_output;
+
+/**
+ * Automatic max_render_time.
+ *
+ * Rendering is delayed until max_render_time milliseconds before the next
+ * predicted refresh, so that frames contain the most recent client content.
+ * Instead of relying on a configured value, the duration of recent frames is
+ * measured, from the start of output_render() to the return of the commit,
+ * and a high percentile of it plus a safety margin is used. The margin grows
+ * whenever a frame misses the refresh it was scheduled for, which also
+ * catches GPU work that the CPU-side measurement doesn't see, and shrinks
+ * back slowly while deadlines are met. Missed frames are counted in the
+ * output metrics.
+ */
+
+#define WLS_RENDER_TIMING_SAMPLES 64
+
+struct wls_output_render_timing {
+    bool automatic;
+
+    // Ring of the most recent render durations, in microseconds
+    uint32_t samples_usec[WLS_RENDER_TIMING_SAMPLES];
+    int samples_next, samples_length;
+    bool estimate_stale;
+    uint32_t estimate_usec;
+
+    uint32_t margin_usec;
+    int deadlines_met; // in a row, since the margin last changed
+
+    // Refresh the frame being scheduled is meant for
+    bool scheduled;
+    struct timespec scheduled_deadline;
+
+    // Same for the last committed frame, until it is presented
+    bool commit_pending;
+    uint32_t commit_seq;
+    struct timespec commit_deadline;
+};
+
+void output_render_timing_init(struct sway_output *output);
+
+/**
+ * Return the number of milliseconds to reserve for rendering before the
+ * next refresh, either configured or estimated. 0 means rendering right
+ * away.
+ */
+int output_get_max_render_time(struct sway_output *output);
+
+/**
+ * Record how long rendering and committing a frame took.
+ */
+void output_render_timing_add_sample(struct sway_output *output,
+        uint32_t usec);
+
+/**
+ * Called when rendering was delayed to meet the refresh predicted at
+ * `deadline`, in the presentation clock.
+ */
+void output_render_timing_schedule(struct sway_output *output,
+        const struct timespec *deadline);
+
+/**
+ * Called when a new frame starts, dropping the deadline of a scheduled frame
+ * that was skipped or failed to commit.
+ */
+void output_render_timing_cancel(struct sway_output *output);
+
+/**
+ * Called once a frame has been committed on the output.
+ */
+void output_render_timing_handle_commit(struct sway_output *output);
+
+/**
+ * Called once the frame with the given commit sequence number has been
+ * presented, at time `when` of the presentation clock.
+ */
+void output_render_timing_handle_present(struct sway_output *output,
+        uint32_t commit_seq, const struct timespec *when,
+        uint32_t refresh_nsec);
+
+#endif /* WLSTEM_RENDER_TIMING_H_ */
@@ -134,6 +134,9 @@ void seat_reset_device(struct sway_seat *seat,
 void seat_remove_device(struct sway_seat *seat,
         struct sway_input_device *device);
 
+// Cursor size of seats without a configured xcursor theme
+#define SEAT_DEFAULT_XCURSOR_SIZE 24
+
 void seat_configure_xcursor(struct sway_seat *seat);
 
 void seat_set_focus(struct sway_seat *seat, struct wls_transaction_node *node);
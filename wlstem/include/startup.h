@@ -0,0 +1,50 @@
+#ifndef WLSTEM_STARTUP_H
+#define WLSTEM_STARTUP_H
+
+/**
+ * Startup phase timing.
+ *
+ * The compositor marks the steps it goes through with wls_startup_phase(),
+ * and independent work can run on helper threads as startup jobs meanwhile.
+ * Once the first frame has been committed, a report with the duration of
+ * every phase and job, and the total time since exec, is logged.
+ */
+
+struct wls_startup_job;
+
+/**
+ * End the current phase, if any, and start a new one. `name` must be a
+ * string literal. Passing NULL only ends the current phase.
+ */
+void wls_startup_phase(const char *name);
+
+/**
+ * Run `func(data)` on a new thread. `name` must be a string literal. The
+ * function must be thread-safe with regards to everything the main thread
+ * does until wls_startup_wait_jobs() is called.
+ *
+ * Returns NULL if the thread can't be created, in which case callers should
+ * do the work themselves.
+ */
+struct wls_startup_job *wls_startup_job_start(const char *name,
+        void *(*func)(void *data), void *data);
+
+/**
+ * Wait for the job to finish, free it, and return what its function returned.
+ */
+void *wls_startup_job_take(struct wls_startup_job *job);
+
+/**
+ * Wait for all the jobs to finish, without taking their results. This must be
+ * called before the main thread does anything the jobs may not race with,
+ * such as modifying the environment.
+ */
+void wls_startup_wait_jobs(void);
+
+/**
+ * Called when a frame has been committed. Ends the current phase and logs the
+ * startup report the first time, does nothing afterwards.
+ */
+void wls_startup_first_frame(void);
+
+#endif
@@ -1,11 +1,16 @@
 #ifndef WLSTEM_SURFACE_H_
 #define WLSTEM_SURFACE_H_
+#include <stdbool.h>
+#include <stdint.h>
 #include <wlr/types/wlr_surface.h>
 
+#define SURFACE_COMMIT_SAMPLES 16
+
 struct sway_surface {
     struct wlr_surface *wlr_surface;
 
     struct wl_listener destroy;
+    struct wl_listener commit;
 
     /**
      * This timer can be used for issuing delayed frame done callbacks (for
@@ -13,6 +18,49 @@ struct sway_surface {
      * function that issues a frame done callback to this surface.
      */
     struct wl_event_source *frame_done_timer;
+
+    // When the last frame done event was sent, in wls_trace_now() time, or
+    // 0 once the client has committed since
+    uint64_t frame_done_nsec;
+    // When the output is expected to render the content committed in
+    // response, 0 if frame done wasn't delayed for it
+    uint64_t frame_deadline_nsec;
+
+    // When frame done was last sent, even without callbacks pending
+    uint64_t frame_done_sent_nsec;
+    // When the surface was last drawn on any output
+    uint64_t rendered_nsec;
+
+    // Time the client took to commit after frame done, in microseconds
+    uint32_t commit_samples_usec[SURFACE_COMMIT_SAMPLES];
+    int commit_samples_next, commit_samples_length;
 };
 
+/**
+ * Record that the surface is being drawn as part of the current frame.
+ * Surfaces that weren't drawn in an output's last frame only get frame done
+ * events at the output's occluded_frame_interval.
+ */
+void surface_note_rendered(struct wlr_surface *surface);
+
+/**
+ * Send frame done to the surface now, and start timing how long the client
+ * takes to commit in response.
+ */
+void surface_send_frame_done(struct sway_surface *surface,
+        const struct timespec *when);
+
+/**
+ * Send frame done after `delay` milliseconds, so that the client commits
+ * just in time for the output to render at `deadline_nsec`.
+ */
+void surface_schedule_frame_done(struct sway_surface *surface, int delay,
+        uint64_t deadline_nsec);
+
+/**
+ * Return the number of milliseconds the client needs between frame done and
+ * its commit, according to its recent commits, or -1 if it isn't known yet.
+ */
+int surface_get_commit_time(struct sway_surface *surface);
+
 #endif
@@ -17,6 +17,24 @@ enum sway_tablet_tool_mode {
     SWAY_TABLET_TOOL_MODE_RELATIVE,
 };
 
+/**
+ * Axis updates of a tablet tool, accumulated between two dispatches.
+ */
+struct sway_tablet_tool_axes {
+    uint32_t updated_axes; // enum wlr_tablet_tool_axes
+    double x, y;
+    double dx, dy;
+    double pressure;
+    double distance;
+    double tilt_x, tilt_y;
+    double rotation;
+    double slider;
+    double wheel_delta;
+
+    uint32_t time_msec;
+    struct wlr_input_device *device;
+};
+
 struct sway_tablet_tool {
     struct sway_seat *seat;
     struct sway_tablet *tablet;
@@ -25,6 +43,15 @@ struct sway_tablet_tool {
     enum sway_tablet_tool_mode mode;
     double tilt_x, tilt_y;
 
+    // If true, axis events received within the same event loop iteration are
+    // merged and dispatched once, when the loop becomes idle. Otherwise every
+    // axis event is dispatched as soon as it arrives, which drawing programs
+    // need. Off unless the tool config enables it; this may be changed at any
+    // time.
+    bool coalesce_axes;
+    struct sway_tablet_tool_axes pending_axes;
+    struct wl_event_source *axes_idle;
+
     struct wl_listener set_cursor;
     struct wl_listener tool_destroy;
 };
@@ -49,6 +76,7 @@ struct sway_tablet_pad {
 struct input_config_tool {
     enum wlr_tablet_tool_type type;
     enum sway_tablet_tool_mode mode;
+    bool coalesce_axes; // if true, merge axis events, see sway_tablet_tool
 };
 
 struct sway_tablet *sway_tablet_create(struct sway_seat *seat,
@@ -0,0 +1,80 @@
+#ifndef WLSTEM_TRACE_H
+#define WLSTEM_TRACE_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Timeline tracing in the Chrome trace-event JSON format, which can be loaded
+ * in chrome://tracing or ui.perfetto.dev.
+ *
+ * Spans are written as complete ("X") events when they end. Tracing is always
+ * compiled in; while it is stopped, a span costs a load and a branch.
+ */
+
+extern bool _wls_trace_enabled;
+
+// Current time in nanoseconds of CLOCK_MONOTONIC_RAW
+uint64_t wls_trace_now(void);
+
+void wls_trace_complete(const char *name, uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * Start a span, to be passed to wls_trace_end(). Returns 0 if tracing is
+ * stopped.
+ */
+static inline uint64_t wls_trace_begin(void) {
+    return _wls_trace_enabled ? wls_trace_now() : 0;
+}
+
+static inline void wls_trace_end(const char *name, uint64_t start_ns) {
+    if (start_ns) {
+        wls_trace_complete(name, start_ns, wls_trace_now());
+    }
+}
+
+struct wls_trace_scope {
+    const char *name;
+    uint64_t start_ns;
+};
+
+static inline void wls_trace_scope_end(struct wls_trace_scope *scope) {
+    wls_trace_end(scope->name, scope->start_ns);
+}
+
+#define _WLS_TRACE_CONCAT2(a, b) a ## b
+#define _WLS_TRACE_CONCAT(a, b) _WLS_TRACE_CONCAT2(a, b)
+
+/**
+ * Trace a span from this point until the end of the enclosing block.
+ */
+#define WLS_TRACE_SCOPE(span_name) \
+    struct wls_trace_scope _WLS_TRACE_CONCAT(_wls_trace_scope_, __LINE__) \
+        __attribute__((cleanup(wls_trace_scope_end))) = { \
+            .name = span_name, \
+            .start_ns = wls_trace_begin(), \
+        }
+
+/**
+ * Start writing a trace to the file at `path`, truncating it. Does nothing and
+ * returns true if a trace is already being written.
+ */
+bool wls_trace_start_file(const char *path);
+
+/**
+ * Start writing a trace to an anonymous memory file. Returns a file
+ * descriptor owned by the caller, from which the trace can be read once
+ * stopped, or -1 on error.
+ */
+int wls_trace_start_memfd(void);
+
+/**
+ * Flush and close the trace being written, if any.
+ */
+void wls_trace_stop(void);
+
+/**
+ * Returns whether a trace is being written.
+ */
+bool wls_trace_active(void);
+
+#endif
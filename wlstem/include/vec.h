@@ -0,0 +1,157 @@
+#ifndef WLSTEM_VEC_H_
+#define WLSTEM_VEC_H_
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log.h"
+
+/**
+ * Type-safe growable arrays.
+ *
+ * WLS_VEC_DEFINE(name, type) declares `struct name` with `items`, `length`
+ * and `capacity` fields, plus static inline name_init(), name_finish(),
+ * name_reserve(), name_shrink(), name_clear(), name_push(), name_insert(),
+ * name_remove(), name_swap_remove() and name_find().
+ *
+ * A zeroed struct is a valid empty vector, so embedding one in a calloc'd
+ * struct doesn't need name_init(). name_remove() preserves the order of the
+ * remaining items, name_swap_remove() moves the last item in place instead.
+ *
+ * WLS_VEC_DEFINE_INDEXED(name, type, field) is the same for pointers to
+ * structs with an `int field` member, which is kept up to date with the
+ * index of the item in the vector. This makes name_find() constant time,
+ * but an item may only be in one such vector at a time. The struct must be
+ * complete where the vector is defined.
+ */
+
+#define _WLS_VEC_NO_INDEX(vec, i, field)
+#define _WLS_VEC_NO_UNINDEX(item, field)
+#define _WLS_VEC_SET_INDEX(vec, i, field) (vec)->items[i]->field = (i)
+#define _WLS_VEC_UNSET_INDEX(item, field) (item)->field = -1
+
+#define _WLS_VEC_DEFINE(name, type, set_index, unset_index, field) \
+struct name { \
+    type *items; \
+    int length; \
+    int capacity; \
+}; \
+\
+static inline void name##_init(struct name *vec) { \
+    vec->items = NULL; \
+    vec->length = vec->capacity = 0; \
+} \
+\
+static inline void name##_finish(struct name *vec) { \
+    free(vec->items); \
+    name##_init(vec); \
+} \
+\
+/* Make room for at least `capacity` items. Returns false on failure */ \
+static inline bool name##_reserve(struct name *vec, int capacity) { \
+    if (capacity <= vec->capacity) { \
+        return true; \
+    } \
+    int new_capacity = vec->capacity ? vec->capacity : 4; \
+    while (new_capacity < capacity) { \
+        new_capacity *= 2; \
+    } \
+    type *items = realloc(vec->items, sizeof(type) * new_capacity); \
+    if (!items) { \
+        sway_log(SWAY_ERROR, "Unable to grow " #name " to %d items", \
+            new_capacity); \
+        return false; \
+    } \
+    vec->items = items; \
+    vec->capacity = new_capacity; \
+    return true; \
+} \
+\
+/* Release the unused capacity */ \
+static inline void name##_shrink(struct name *vec) { \
+    if (vec->length == vec->capacity) { \
+        return; \
+    } \
+    if (vec->length == 0) { \
+        name##_finish(vec); \
+        return; \
+    } \
+    type *items = realloc(vec->items, sizeof(type) * vec->length); \
+    if (items) { \
+        vec->items = items; \
+        vec->capacity = vec->length; \
+    } \
+} \
+\
+static inline void name##_clear(struct name *vec) { \
+    for (int i = 0; i < vec->length; ++i) { \
+        unset_index(vec->items[i], field); \
+    } \
+    vec->length = 0; \
+} \
+\
+static inline bool name##_push(struct name *vec, type item) { \
+    if (!name##_reserve(vec, vec->length + 1)) { \
+        return false; \
+    } \
+    vec->items[vec->length] = item; \
+    set_index(vec, vec->length, field); \
+    vec->length++; \
+    return true; \
+} \
+\
+static inline bool name##_insert(struct name *vec, int index, type item) { \
+    if (!name##_reserve(vec, vec->length + 1)) { \
+        return false; \
+    } \
+    memmove(&vec->items[index + 1], &vec->items[index], \
+        sizeof(type) * (vec->length - index)); \
+    vec->items[index] = item; \
+    vec->length++; \
+    for (int i = index; i < vec->length; ++i) { \
+        set_index(vec, i, field); \
+    } \
+    return true; \
+} \
+\
+static inline void name##_remove(struct name *vec, int index) { \
+    unset_index(vec->items[index], field); \
+    vec->length--; \
+    memmove(&vec->items[index], &vec->items[index + 1], \
+        sizeof(type) * (vec->length - index)); \
+    for (int i = index; i < vec->length; ++i) { \
+        set_index(vec, i, field); \
+    } \
+} \
+\
+static inline void name##_swap_remove(struct name *vec, int index) { \
+    unset_index(vec->items[index], field); \
+    vec->length--; \
+    if (index != vec->length) { \
+        vec->items[index] = vec->items[vec->length]; \
+        set_index(vec, index, field); \
+    } \
+}
+
+#define WLS_VEC_DEFINE(name, type) \
+_WLS_VEC_DEFINE(name, type, _WLS_VEC_NO_INDEX, _WLS_VEC_NO_UNINDEX, _) \
+\
+/* Return the index of the item, or -1 */ \
+static inline int name##_find(const struct name *vec, const type item) { \
+    for (int i = 0; i < vec->length; ++i) { \
+        if (vec->items[i] == item) { \
+            return i; \
+        } \
+    } \
+    return -1; \
+}
+
+#define WLS_VEC_DEFINE_INDEXED(name, type, field) \
+_WLS_VEC_DEFINE(name, type, _WLS_VEC_SET_INDEX, _WLS_VEC_UNSET_INDEX, field) \
+\
+/* Return the index of the item, or -1 */ \
+static inline int name##_find(const struct name *vec, const type item) { \
+    int i = item->field; \
+    return i >= 0 && i < vec->length && vec->items[i] == item ? i : -1; \
+}
+
+#endif /* WLSTEM_VEC_H_ */
@@ -63,6 +63,7 @@ struct sway_saved_buffer {
     int width, height;
     enum wl_output_transform transform;
     struct wlr_fbox source_box;
+    size_t bytes; // approximate size of the texture, for the metrics
     struct wl_list link; // sway_view::saved_buffers
 };
 
@@ -6,6 +6,7 @@
 #include <wlr/types/wlr_surface.h>
 #include "list.h"
 #include "node.h"
+#include "vec.h"
 
 struct sway_view;
 struct sway_seat;
@@ -15,6 +16,8 @@ struct sway_view;
 
 enum wlr_direction;
 
+WLS_VEC_DEFINE(wls_output_vec, struct sway_output *)
+
 struct wls_window_state {
     // Window properties
     double x, y;
@@ -58,7 +61,7 @@ struct wls_window {
     struct sway_output *output;
 
     // Outputs currently being intersected
-    list_t *outputs; // struct sway_output
+    struct wls_output_vec outputs;
 
     float alpha;
 
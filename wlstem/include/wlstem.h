@@ -5,6 +5,7 @@
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_tablet_v2.h>
 #include "list.h"
+#include "metrics.h"
 #include "node.h"
 #include "misc_protocols.h"
 #include "user_callbacks.h"
@@ -16,6 +17,7 @@ struct wls_debug {
     bool noatomic;         // Ignore atomic layout updates
     bool txn_timings;      // Log verbose messages about transactions
     bool txn_wait;         // Always wait for the timeout before applying
+    bool frame_cache;      // Redraw cursor-only frames from a scene copy
 
     enum {
         DAMAGE_DEFAULT,    // Default behaviour
@@ -24,6 +26,11 @@ struct wls_debug {
     } damage;
 
     size_t transaction_timeout_ms; // 0 means use default timeout
+    size_t profile_interval_ms;    // 0 means don't profile callbacks
+    const char *trace_path;        // Where SIGUSR2 writes traces, if not NULL
+    bool trace;                    // Start tracing at startup
+    bool metrics;                  // Serve metrics on a Unix socket
+    const char *metrics_path;      // Where they are served, if not NULL
 };
 
 struct wls_context {
@@ -31,14 +38,18 @@ struct wls_context {
     struct wls_node_manager *node_manager;
     struct wls_output_manager *output_manager;
     list_t *output_configs;
+    uint32_t output_configs_generation; // bumped when output_configs changes
     struct wls_input_method_manager *input_method_manager;
     struct wlr_tablet_manager_v2 *tablet_v2;
     struct wl_list seats;
+    struct wl_list xcursor_themes; // wls_xcursor_cache_entry::link
     struct sway_seat *current_seat;
     struct wls_misc_protocols *misc_protocols;
 
     struct wls_user_callbacks user_callbacks;
 
+    struct wls_metrics metrics;
+
     struct wls_debug debug;
     struct {
         struct wl_signal new_window;
@@ -0,0 +1,47 @@
+#ifndef WLSTEM_XCURSOR_CACHE_H
+#define WLSTEM_XCURSOR_CACHE_H
+#include <stdbool.h>
+#include <wlr/types/wlr_xcursor_manager.h>
+
+/**
+ * Process-wide cache of xcursor themes.
+ *
+ * Seats (and Xwayland) borrow a wlr_xcursor_manager per (theme name, size)
+ * instead of creating their own, so that each theme is only read from disk
+ * once per scale, whatever the number of users.
+ */
+
+/**
+ * Return the shared manager for the given theme and size, creating it if
+ * needed. `name` may be NULL for the default theme. Each successful call must
+ * be balanced by a call to wls_xcursor_cache_release().
+ */
+struct wlr_xcursor_manager *wls_xcursor_cache_acquire(const char *name,
+        unsigned size);
+
+/**
+ * Drop a reference obtained through wls_xcursor_cache_acquire(). The manager
+ * and its loaded themes are destroyed once the last reference is gone.
+ * Does nothing if `manager` is NULL.
+ */
+void wls_xcursor_cache_release(struct wlr_xcursor_manager *manager);
+
+/**
+ * Make sure the theme is loaded for the given scale. Loading a scale that
+ * another user of the manager already requested is free.
+ */
+bool wls_xcursor_cache_load(struct wlr_xcursor_manager *manager, float scale);
+
+/**
+ * Read the theme for the given scale on a startup job, so that its files are
+ * in the page cache by the time wls_xcursor_cache_load() needs them. Only one
+ * theme can be prefetched at a time.
+ */
+void wls_xcursor_cache_prefetch(const char *name, unsigned size, float scale);
+
+/**
+ * Wait for the prefetch job, if any.
+ */
+void wls_xcursor_cache_finish(void);
+
+#endif
@@ -1,3 +1,7 @@
+#define SWAY_LOG_CATEGORY SWAY_LOG_INPUT
+#include <math.h>
+#include <pixman.h>
+#include <wlr/types/wlr_cursor.h>
 #include "cursor.h"
 #include "seat.h"
 #include "util.h"
@@ -9,7 +13,8 @@ void cursor_rebase(struct sway_cursor *cursor) {
 }
 
 void cursor_rebase_all(void) {
-    if (!wls->output_manager->outputs->length) {
+    cursor_invalidate_all_touch_points();
+    if (!wls->output_manager->outputs.length) {
         return;
     }
 
@@ -18,3 +23,38 @@ void cursor_rebase_all(void) {
         cursor_rebase(seat->cursor);
     }
 }
+
+void cursor_rebase_region(pixman_region32_t *region) {
+    if (!wls->output_manager->outputs.length
+            || !pixman_region32_not_empty(region)) {
+        return;
+    }
+
+    struct sway_seat *seat;
+    wl_list_for_each(seat, &wls->seats, link) {
+        struct wlr_cursor *wlr_cursor = seat->cursor->cursor;
+        if (pixman_region32_contains_point(region,
+                floor(wlr_cursor->x), floor(wlr_cursor->y), NULL)) {
+            cursor_rebase(seat->cursor);
+        }
+    }
+}
+
+void cursor_invalidate_touch_points(struct sway_cursor *cursor) {
+    for (size_t i = 0; i < SWAY_CURSOR_TOUCH_POINTS_CAP; ++i) {
+        struct sway_touch_point *point = &cursor->touch_points[i];
+        if (!point->surface) {
+            continue;
+        }
+        wl_list_remove(&point->surface_destroy.link);
+        wl_list_init(&point->surface_destroy.link);
+        point->surface = NULL;
+    }
+}
+
+void cursor_invalidate_all_touch_points(void) {
+    struct sway_seat *seat;
+    wl_list_for_each(seat, &wls->seats, link) {
+        cursor_invalidate_touch_points(seat->cursor);
+    }
+}
@@ -0,0 +1,125 @@
+#define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_INPUT
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-util.h>
+#include <wlr/types/wlr_xcursor_manager.h>
+#include "log.h"
+#include "startup.h"
+#include "wlstem.h"
+#include "xcursor_cache.h"
+
+struct wls_xcursor_cache_entry {
+    struct wlr_xcursor_manager *manager;
+    int refcount;
+    struct wl_list link; // wls_context::xcursor_themes
+};
+
+// Startup job warming the page cache, see wls_xcursor_cache_prefetch()
+static struct {
+    struct wls_startup_job *job;
+    char *name;
+    unsigned size;
+} prefetch = {0};
+
+static bool names_equal(const char *a, const char *b) {
+    return (!a && !b) || (a && b && strcmp(a, b) == 0);
+}
+
+static struct wls_xcursor_cache_entry *entry_from_manager(
+        struct wlr_xcursor_manager *manager) {
+    struct wls_xcursor_cache_entry *entry;
+    wl_list_for_each(entry, &wls->xcursor_themes, link) {
+        if (entry->manager == manager) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+struct wlr_xcursor_manager *wls_xcursor_cache_acquire(const char *name,
+        unsigned size) {
+    struct wls_xcursor_cache_entry *entry;
+    wl_list_for_each(entry, &wls->xcursor_themes, link) {
+        if (entry->manager->size == size &&
+                names_equal(entry->manager->name, name)) {
+            entry->refcount++;
+            return entry->manager;
+        }
+    }
+
+    entry = calloc(1, sizeof(struct wls_xcursor_cache_entry));
+    if (!sway_assert(entry, "Failed to allocate xcursor cache entry")) {
+        return NULL;
+    }
+    entry->manager = wlr_xcursor_manager_create(name, size);
+    if (!entry->manager) {
+        sway_log(SWAY_ERROR, "Cannot create XCursor manager for theme '%s'",
+            name);
+        free(entry);
+        return NULL;
+    }
+    entry->refcount = 1;
+    wl_list_insert(&wls->xcursor_themes, &entry->link);
+    sway_log(SWAY_DEBUG, "Created shared XCursor manager for theme '%s' "
+        "size %u", name ? name : "default", size);
+    return entry->manager;
+}
+
+void wls_xcursor_cache_release(struct wlr_xcursor_manager *manager) {
+    if (!manager) {
+        return;
+    }
+    struct wls_xcursor_cache_entry *entry = entry_from_manager(manager);
+    if (!sway_assert(entry, "XCursor manager isn't from the cache")) {
+        return;
+    }
+    if (--entry->refcount > 0) {
+        return;
+    }
+    wl_list_remove(&entry->link);
+    wlr_xcursor_manager_destroy(entry->manager);
+    free(entry);
+}
+
+static void *warm_theme(void *data) {
+    // Reading the theme pulls its files into the page cache, after which
+    // wlr_xcursor_manager_load() only has to parse them
+    struct wlr_xcursor_theme *theme =
+        wlr_xcursor_theme_load(prefetch.name, prefetch.size);
+    if (theme) {
+        wlr_xcursor_theme_destroy(theme);
+    }
+    return NULL;
+}
+
+void wls_xcursor_cache_prefetch(const char *name, unsigned size, float scale) {
+    if (prefetch.job) {
+        return;
+    }
+    prefetch.name = name ? strdup(name) : NULL;
+    prefetch.size = size * scale;
+    prefetch.job = wls_startup_job_start("xcursor theme", warm_theme, NULL);
+    if (!prefetch.job) {
+        free(prefetch.name);
+        prefetch.name = NULL;
+    }
+}
+
+void wls_xcursor_cache_finish(void) {
+    if (!prefetch.job) {
+        return;
+    }
+    wls_startup_job_take(prefetch.job);
+    free(prefetch.name);
+    prefetch.name = NULL;
+    prefetch.job = NULL;
+}
+
+bool wls_xcursor_cache_load(struct wlr_xcursor_manager *manager, float scale) {
+    if (!manager) {
+        return false;
+    }
+    // wlr_xcursor_manager_load() is a no-op for already loaded scales
+    return wlr_xcursor_manager_load(manager, scale);
+}
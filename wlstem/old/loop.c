@@ -1,16 +1,20 @@
 #define _POSIX_C_SOURCE 200112L
+#include <errno.h>
 #include <limits.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <poll.h>
+#include <sys/epoll.h>
 #include <time.h>
 #include <unistd.h>
-#include "list.h"
 #include "log.h"
 #include "loop.h"
 
+// Maximum number of fd events dispatched per loop_poll()
+#define LOOP_MAX_EVENTS 32
+
 struct loop_fd_event {
     void (*callback)(int fd, short mask, void *data);
     void *data;
@@ -20,15 +24,20 @@ struct loop_timer {
     void (*callback)(void *data);
     void *data;
     struct timespec expiry;
+    int index; // in loop::timers, -1 if not in the heap
 };
 
 struct loop {
-    struct pollfd *fds;
-    int fd_length;
-    int fd_capacity;
+    int epoll_fd;
+
+    // Indexed by fd, so that removal doesn't need a search
+    struct loop_fd_event **fd_events;
+    int fd_events_capacity;
 
-    list_t *fd_events; // struct loop_fd_event
-    list_t *timers; // struct loop_timer
+    // Binary min-heap ordered by expiry
+    struct loop_timer **timers;
+    int timers_length;
+    int timers_capacity;
 };
 
 struct loop *loop_create(void) {
@@ -37,74 +46,199 @@ struct loop *loop_create(void) {
         sway_log(SWAY_ERROR, "Unable to allocate memory for loop");
         return NULL;
     }
-    loop->fd_capacity = 10;
-    loop->fds = malloc(sizeof(struct pollfd) * loop->fd_capacity);
-    loop->fd_events = create_list();
-    loop->timers = create_list();
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epoll_fd < 0) {
+        sway_log_errno(SWAY_ERROR, "Unable to create epoll instance");
+        free(loop);
+        return NULL;
+    }
     return loop;
 }
 
 void loop_destroy(struct loop *loop) {
-    list_free_items_and_destroy(loop->fd_events);
-    list_free_items_and_destroy(loop->timers);
-    free(loop->fds);
+    for (int i = 0; i < loop->fd_events_capacity; ++i) {
+        free(loop->fd_events[i]);
+    }
+    free(loop->fd_events);
+    for (int i = 0; i < loop->timers_length; ++i) {
+        free(loop->timers[i]);
+    }
+    free(loop->timers);
+    close(loop->epoll_fd);
     free(loop);
 }
 
-void loop_poll(struct loop *loop) {
-    // Calculate next timer in ms
-    int ms = INT_MAX;
-    if (loop->timers->length) {
-        struct timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        for (int i = 0; i < loop->timers->length; ++i) {
-            struct loop_timer *timer = loop->timers->items[i];
-            int timer_ms = (timer->expiry.tv_sec - now.tv_sec) * 1000;
-            timer_ms += (timer->expiry.tv_nsec - now.tv_nsec) / 1000000;
-            if (timer_ms < ms) {
-                ms = timer_ms;
-            }
+static bool timespec_before(const struct timespec *a,
+        const struct timespec *b) {
+    return a->tv_sec < b->tv_sec ||
+        (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static void heap_swap(struct loop *loop, int a, int b) {
+    struct loop_timer *tmp = loop->timers[a];
+    loop->timers[a] = loop->timers[b];
+    loop->timers[b] = tmp;
+    loop->timers[a]->index = a;
+    loop->timers[b]->index = b;
+}
+
+static void heap_sift_up(struct loop *loop, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!timespec_before(&loop->timers[i]->expiry,
+                &loop->timers[parent]->expiry)) {
+            break;
         }
+        heap_swap(loop, i, parent);
+        i = parent;
     }
-    if (ms < 0) {
-        ms = 0;
+}
+
+static void heap_sift_down(struct loop *loop, int i) {
+    for (;;) {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < loop->timers_length && timespec_before(
+                &loop->timers[left]->expiry, &loop->timers[smallest]->expiry)) {
+            smallest = left;
+        }
+        if (right < loop->timers_length && timespec_before(
+                &loop->timers[right]->expiry, &loop->timers[smallest]->expiry)) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        heap_swap(loop, i, smallest);
+        i = smallest;
     }
+}
 
-    poll(loop->fds, loop->fd_length, ms);
+static void heap_remove(struct loop *loop, struct loop_timer *timer) {
+    int i = timer->index;
+    int last = --loop->timers_length;
+    if (i != last) {
+        loop->timers[i] = loop->timers[last];
+        loop->timers[i]->index = i;
+        heap_sift_down(loop, i);
+        heap_sift_up(loop, i);
+    }
+    timer->index = -1;
+}
 
-    // Dispatch fds
-    for (int i = 0; i < loop->fd_length; ++i) {
-        struct pollfd pfd = loop->fds[i];
-        struct loop_fd_event *event = loop->fd_events->items[i];
+static int next_timeout_ms(struct loop *loop) {
+    if (!loop->timers_length) {
+        return -1;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const struct timespec *expiry = &loop->timers[0]->expiry;
+    if (!timespec_before(&now, expiry)) {
+        return 0;
+    }
+    long long ns = (long long)(expiry->tv_sec - now.tv_sec) * 1000000000 +
+        (expiry->tv_nsec - now.tv_nsec);
+    // Round up, so that we don't wake up right before the expiry
+    long long ms = (ns + 999999) / 1000000;
+    return ms > INT_MAX ? INT_MAX : (int)ms;
+}
 
-        // Always send these events
-        unsigned events = pfd.events | POLLHUP | POLLERR;
+static uint32_t poll_to_epoll(short mask) {
+    uint32_t events = 0;
+    if (mask & POLLIN) {
+        events |= EPOLLIN;
+    }
+    if (mask & POLLPRI) {
+        events |= EPOLLPRI;
+    }
+    if (mask & POLLOUT) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
 
-        if (pfd.revents & events) {
-            event->callback(pfd.fd, pfd.revents, event->data);
+static short epoll_to_poll(uint32_t events) {
+    short mask = 0;
+    if (events & EPOLLIN) {
+        mask |= POLLIN;
+    }
+    if (events & EPOLLPRI) {
+        mask |= POLLPRI;
+    }
+    if (events & EPOLLOUT) {
+        mask |= POLLOUT;
+    }
+    if (events & EPOLLERR) {
+        mask |= POLLERR;
+    }
+    if (events & EPOLLHUP) {
+        mask |= POLLHUP;
+    }
+    return mask;
+}
+
+void loop_poll(struct loop *loop) {
+    struct epoll_event events[LOOP_MAX_EVENTS];
+    int n = epoll_wait(loop->epoll_fd, events, LOOP_MAX_EVENTS,
+        next_timeout_ms(loop));
+    if (n < 0 && errno != EINTR) {
+        sway_log_errno(SWAY_ERROR, "epoll_wait failed");
+    }
+
+    // Dispatch fds. Callbacks may remove fds, so look the events up again
+    // instead of keeping pointers to them.
+    for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+        struct loop_fd_event *event = fd < loop->fd_events_capacity ?
+            loop->fd_events[fd] : NULL;
+        if (event) {
+            event->callback(fd, epoll_to_poll(events[i].events), event->data);
         }
     }
 
     // Dispatch timers
-    if (loop->timers->length) {
+    if (loop->timers_length) {
         struct timespec now;
         clock_gettime(CLOCK_MONOTONIC, &now);
-        for (int i = 0; i < loop->timers->length; ++i) {
-            struct loop_timer *timer = loop->timers->items[i];
-            bool expired = timer->expiry.tv_sec < now.tv_sec ||
-                (timer->expiry.tv_sec == now.tv_sec &&
-                 timer->expiry.tv_nsec < now.tv_nsec);
-            if (expired) {
-                timer->callback(timer->data);
-                loop_remove_timer(loop, timer);
-                --i;
-            }
+        while (loop->timers_length &&
+                !timespec_before(&now, &loop->timers[0]->expiry)) {
+            // The timer belongs to the caller until loop_remove_timer(), which
+            // the callback may call
+            struct loop_timer *timer = loop->timers[0];
+            heap_remove(loop, timer);
+            timer->callback(timer->data);
         }
     }
 }
 
 void loop_add_fd(struct loop *loop, int fd, short mask,
         void (*callback)(int fd, short mask, void *data), void *data) {
+    if (fd < 0) {
+        return;
+    }
+    if (fd >= loop->fd_events_capacity) {
+        int capacity = loop->fd_events_capacity ? loop->fd_events_capacity : 16;
+        while (capacity <= fd) {
+            capacity *= 2;
+        }
+        struct loop_fd_event **tmp = realloc(loop->fd_events,
+                sizeof(struct loop_fd_event *) * capacity);
+        if (!tmp) {
+            sway_log(SWAY_ERROR, "Unable to allocate memory for fd events");
+            return;
+        }
+        memset(&tmp[loop->fd_events_capacity], 0,
+            sizeof(struct loop_fd_event *) *
+            (capacity - loop->fd_events_capacity));
+        loop->fd_events = tmp;
+        loop->fd_events_capacity = capacity;
+    }
+    if (loop->fd_events[fd]) {
+        sway_log(SWAY_ERROR, "fd %d is already in the loop", fd);
+        return;
+    }
+
     struct loop_fd_event *event = calloc(1, sizeof(struct loop_fd_event));
     if (!event) {
         sway_log(SWAY_ERROR, "Unable to allocate memory for event");
@@ -112,27 +246,33 @@ void loop_add_fd(struct loop *loop, int fd, short mask,
     }
     event->callback = callback;
     event->data = data;
-    list_add(loop->fd_events, event);
-
-    struct pollfd pfd = {fd, mask, 0};
 
-    if (loop->fd_length == loop->fd_capacity) {
-        int capacity = loop->fd_capacity + 10;
-        struct pollfd *tmp = realloc(loop->fds,
-                sizeof(struct pollfd) * capacity);
-        if (!tmp) {
-            sway_log(SWAY_ERROR, "Unable to allocate memory for pollfd");
-            return;
-        }
-        loop->fds = tmp;
-        loop->fd_capacity = capacity;
+    struct epoll_event ev = {
+        .events = poll_to_epoll(mask),
+        .data.fd = fd,
+    };
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        sway_log_errno(SWAY_ERROR, "Unable to add fd %d to the loop", fd);
+        free(event);
+        return;
     }
-
-    loop->fds[loop->fd_length++] = pfd;
+    loop->fd_events[fd] = event;
 }
 
 struct loop_timer *loop_add_timer(struct loop *loop, int ms,
         void (*callback)(void *data), void *data) {
+    if (loop->timers_length == loop->timers_capacity) {
+        int capacity = loop->timers_capacity ? loop->timers_capacity * 2 : 16;
+        struct loop_timer **tmp = realloc(loop->timers,
+                sizeof(struct loop_timer *) * capacity);
+        if (!tmp) {
+            sway_log(SWAY_ERROR, "Unable to allocate memory for timers");
+            return NULL;
+        }
+        loop->timers = tmp;
+        loop->timers_capacity = capacity;
+    }
+
     struct loop_timer *timer = calloc(1, sizeof(struct loop_timer));
     if (!timer) {
         sway_log(SWAY_ERROR, "Unable to allocate memory for timer");
@@ -151,34 +291,30 @@ struct loop_timer *loop_add_timer(struct loop *loop, int ms,
     }
     timer->expiry.tv_nsec += nsec;
 
-    list_add(loop->timers, timer);
+    timer->index = loop->timers_length++;
+    loop->timers[timer->index] = timer;
+    heap_sift_up(loop, timer->index);
 
     return timer;
 }
 
 bool loop_remove_fd(struct loop *loop, int fd) {
-    for (int i = 0; i < loop->fd_length; ++i) {
-        if (loop->fds[i].fd == fd) {
-            free(loop->fd_events->items[i]);
-            list_del(loop->fd_events, i);
-
-            loop->fd_length--;
-            memmove(&loop->fds[i], &loop->fds[i + 1],
-                    sizeof(struct pollfd) * (loop->fd_length - i));
-
-            return true;
-        }
+    if (fd < 0 || fd >= loop->fd_events_capacity || !loop->fd_events[fd]) {
+        return false;
     }
-    return false;
+    // The fd may already be closed, in which case the kernel dropped it
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    free(loop->fd_events[fd]);
+    loop->fd_events[fd] = NULL;
+    return true;
 }
 
 bool loop_remove_timer(struct loop *loop, struct loop_timer *timer) {
-    for (int i = 0; i < loop->timers->length; ++i) {
-        if (loop->timers->items[i] == timer) {
-            list_del(loop->timers, i);
-            free(timer);
-            return true;
-        }
+    // Expired timers were already taken out of the heap, see loop_poll()
+    bool pending = timer->index >= 0;
+    if (pending) {
+        heap_remove(loop, timer);
     }
-    return false;
+    free(timer);
+    return pending;
 }
@@ -0,0 +1,273 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <time.h>
+#include <wlr/backend.h>
+#include <wlr/types/wlr_input_device.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_output_layout.h>
+#include "latency.h"
+#include "output.h"
+#include "output_manager.h"
+#include "server.h"
+#include "wlstem.h"
+
+// Deltas above this are assumed to come from mismatched clocks
+#define MAX_SANE_LATENCY_USEC (10 * 1000000)
+
+// Input and damage that didn't make it into a frame after this many refresh
+// periods (and at least PENDING_EXPIRY_MIN_USEC) are assumed to have produced
+// nothing to show, and are dropped
+#define PENDING_EXPIRY_REFRESHES 3
+#define PENDING_EXPIRY_MIN_USEC (100 * 1000)
+
+static const char *source_names[] = {
+    [WLS_LATENCY_SOURCE_POINTER] = "pointer",
+    [WLS_LATENCY_SOURCE_KEYBOARD] = "keyboard",
+    [WLS_LATENCY_SOURCE_TOUCH] = "touch",
+    [WLS_LATENCY_SOURCE_TABLET] = "tablet",
+};
+
+static const char *stage_names[] = {
+    [WLS_LATENCY_INPUT_TO_COMMIT] = "input_to_commit",
+    [WLS_LATENCY_COMMIT_TO_PRESENT] = "commit_to_present",
+    [WLS_LATENCY_INPUT_TO_PRESENT] = "input_to_present",
+};
+
+const char *wls_latency_source_name(enum wls_latency_source source) {
+    return source < WLS_LATENCY_SOURCE_COUNT ? source_names[source] : NULL;
+}
+
+enum wls_latency_source wls_latency_source_from_device(
+        struct wlr_input_device *device) {
+    switch (device->type) {
+    case WLR_INPUT_DEVICE_KEYBOARD:
+        return WLS_LATENCY_SOURCE_KEYBOARD;
+    case WLR_INPUT_DEVICE_POINTER:
+        return WLS_LATENCY_SOURCE_POINTER;
+    case WLR_INPUT_DEVICE_TOUCH:
+        return WLS_LATENCY_SOURCE_TOUCH;
+    case WLR_INPUT_DEVICE_TABLET_TOOL:
+    case WLR_INPUT_DEVICE_TABLET_PAD:
+        return WLS_LATENCY_SOURCE_TABLET;
+    case WLR_INPUT_DEVICE_SWITCH:
+        break;
+    }
+    return WLS_LATENCY_SOURCE_COUNT;
+}
+
+const char *wls_latency_stage_name(enum wls_latency_stage stage) {
+    return stage < WLS_LATENCY_STAGE_COUNT ? stage_names[stage] : NULL;
+}
+
+void wls_latency_histogram_add(struct wls_latency_histogram *histogram,
+        int64_t usec) {
+    if (usec < 0 || usec > MAX_SANE_LATENCY_USEC) {
+        return;
+    }
+
+    size_t i = 0;
+    while (i < WLS_LATENCY_BUCKETS - 1 &&
+            (uint64_t)usec >= ((uint64_t)WLS_LATENCY_BUCKET_BASE_USEC << i)) {
+        ++i;
+    }
+    histogram->buckets[i]++;
+    histogram->count++;
+    histogram->sum_usec += usec;
+    if ((uint64_t)usec > histogram->max_usec) {
+        histogram->max_usec = usec;
+    }
+}
+
+uint64_t wls_latency_histogram_percentile(
+        const struct wls_latency_histogram *histogram, double percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = histogram->count * percentile / 100.0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < WLS_LATENCY_BUCKETS - 1; ++i) {
+        seen += histogram->buckets[i];
+        if (seen > rank) {
+            return (uint64_t)WLS_LATENCY_BUCKET_BASE_USEC << i;
+        }
+    }
+    return histogram->max_usec;
+}
+
+/**
+ * Return the microseconds elapsed between an input timestamp and `now`,
+ * both in CLOCK_MONOTONIC.
+ */
+static int64_t usec_since_input(uint32_t time_msec,
+        const struct timespec *now) {
+    // Input timestamps are 32-bit milliseconds, so compare them modulo 2^32
+    uint32_t now_msec = (uint32_t)(now->tv_sec * 1000 + now->tv_nsec / 1000000);
+    int32_t msec = (int32_t)(now_msec - time_msec);
+    return (int64_t)msec * 1000 + (now->tv_nsec / 1000) % 1000;
+}
+
+static int64_t timespec_sub_usec(const struct timespec *a,
+        const struct timespec *b) {
+    return (int64_t)(a->tv_sec - b->tv_sec) * 1000000 +
+        (a->tv_nsec - b->tv_nsec) / 1000;
+}
+
+static int64_t pending_expiry_usec(struct sway_output *output) {
+    int64_t usec = (int64_t)output->refresh_nsec * PENDING_EXPIRY_REFRESHES
+        / 1000;
+    return usec > PENDING_EXPIRY_MIN_USEC ? usec : PENDING_EXPIRY_MIN_USEC;
+}
+
+/**
+ * Convert a time of the backend's presentation clock to CLOCK_MONOTONIC, the
+ * clock of input timestamps.
+ */
+static void presentation_to_monotonic(struct timespec *mono,
+        const struct timespec *when) {
+    clockid_t clock = wlr_backend_get_presentation_clock(wls->server->backend);
+    if (clock == CLOCK_MONOTONIC) {
+        *mono = *when;
+        return;
+    }
+    struct timespec pres_now, mono_now;
+    clock_gettime(clock, &pres_now);
+    clock_gettime(CLOCK_MONOTONIC, &mono_now);
+    int64_t nsec = (int64_t)(when->tv_sec - pres_now.tv_sec) * 1000000000 +
+        (when->tv_nsec - pres_now.tv_nsec) +
+        (int64_t)mono_now.tv_sec * 1000000000 + mono_now.tv_nsec;
+    mono->tv_sec = nsec / 1000000000;
+    mono->tv_nsec = nsec % 1000000000;
+}
+
+static void count_input(enum wls_latency_source source) {
+    if (source < WLS_LATENCY_SOURCE_COUNT) {
+        wls->metrics.input_events[source]++;
+    }
+}
+
+static void note_input(struct sway_output *output,
+        enum wls_latency_source source, uint32_t time_msec) {
+    if (!output || !output->enabled || source >= WLS_LATENCY_SOURCE_COUNT) {
+        return;
+    }
+    struct wls_output_latency *latency = &output->latency;
+    // Keep the oldest event, the frame is as late as its earliest input,
+    // unless it expired without producing a frame
+    int32_t age_msec = (int32_t)(time_msec - latency->input_msec[source]);
+    if (!latency->input_pending[source] ||
+            (int64_t)age_msec * 1000 > pending_expiry_usec(output)) {
+        latency->input_pending[source] = true;
+        latency->input_msec[source] = time_msec;
+    }
+}
+
+void output_latency_note_input(struct sway_output *output,
+        enum wls_latency_source source, uint32_t time_msec) {
+    count_input(source);
+    note_input(output, source, time_msec);
+}
+
+void wls_latency_note_input_at(enum wls_latency_source source,
+        uint32_t time_msec, double lx, double ly) {
+    count_input(source);
+    struct wlr_output *wlr_output = wlr_output_layout_output_at(
+        wls->output_manager->output_layout, lx, ly);
+    if (!wlr_output || !wlr_output->data) {
+        return;
+    }
+    note_input(wlr_output->data, source, time_msec);
+}
+
+void output_latency_note_damage(struct sway_output *output) {
+    struct wls_output_latency *latency = &output->latency;
+    // Keep the oldest damage, like for input events
+    struct timespec now;
+    clock_gettime(wlr_backend_get_presentation_clock(wls->server->backend),
+        &now);
+    if (!latency->damage_pending || timespec_sub_usec(&now,
+            &latency->damage_time) > pending_expiry_usec(output)) {
+        latency->damage_pending = true;
+        latency->damage_time = now;
+    }
+}
+
+void output_latency_handle_commit(struct sway_output *output) {
+    struct wls_output_latency *latency = &output->latency;
+    bool any = latency->damage_pending;
+    for (size_t i = 0; i < WLS_LATENCY_SOURCE_COUNT; ++i) {
+        any |= latency->input_pending[i];
+    }
+    if (!any) {
+        return;
+    }
+
+    // Only monotonic input timestamps can be compared, but presentation
+    // times are in the backend's presentation clock (also monotonic for DRM)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    clock_gettime(wlr_backend_get_presentation_clock(wls->server->backend),
+        &latency->commit_time);
+    latency->commit_seq = output->wlr_output->commit_seq;
+    int64_t expiry_usec = pending_expiry_usec(output);
+
+    latency->commit_damage_pending = latency->damage_pending &&
+        timespec_sub_usec(&latency->commit_time, &latency->damage_time) <=
+            expiry_usec;
+    latency->commit_damage_time = latency->damage_time;
+    latency->commit_adaptive_sync = output_adaptive_sync_active(output);
+    latency->damage_pending = false;
+
+    for (size_t i = 0; i < WLS_LATENCY_SOURCE_COUNT; ++i) {
+        // A frame that was never presented is superseded by this one
+        latency->commit_pending[i] = false;
+        latency->commit_input_msec[i] = latency->input_msec[i];
+        if (!latency->input_pending[i]) {
+            continue;
+        }
+        latency->input_pending[i] = false;
+        int64_t input_to_commit =
+            usec_since_input(latency->input_msec[i], &now);
+        if (input_to_commit > expiry_usec) {
+            continue;
+        }
+        latency->commit_pending[i] = true;
+        wls_latency_histogram_add(
+            &latency->histograms[i][WLS_LATENCY_INPUT_TO_COMMIT],
+            input_to_commit);
+    }
+}
+
+void output_latency_handle_present(struct sway_output *output,
+        uint32_t commit_seq, const struct timespec *when) {
+    struct wls_output_latency *latency = &output->latency;
+    if (!when || commit_seq != latency->commit_seq) {
+        return;
+    }
+
+    if (latency->commit_damage_pending) {
+        latency->commit_damage_pending = false;
+        wls_latency_histogram_add(&output->metrics.damage_to_present[
+            latency->commit_adaptive_sync],
+            timespec_sub_usec(when, &latency->commit_damage_time));
+    }
+
+    int64_t commit_to_present = timespec_sub_usec(when, &latency->commit_time);
+    struct timespec when_monotonic;
+    presentation_to_monotonic(&when_monotonic, when);
+    for (size_t i = 0; i < WLS_LATENCY_SOURCE_COUNT; ++i) {
+        if (!latency->commit_pending[i]) {
+            continue;
+        }
+        latency->commit_pending[i] = false;
+        struct wls_latency_histogram *histograms = latency->histograms[i];
+        wls_latency_histogram_add(&histograms[WLS_LATENCY_COMMIT_TO_PRESENT],
+            commit_to_present);
+        wls_latency_histogram_add(&histograms[WLS_LATENCY_INPUT_TO_PRESENT],
+            usec_since_input(latency->commit_input_msec[i], &when_monotonic));
+    }
+}
+
+#undef MAX_SANE_LATENCY_USEC
+#undef PENDING_EXPIRY_REFRESHES
+#undef PENDING_EXPIRY_MIN_USEC
@@ -1,6 +1,8 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_OUTPUT
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_output_damage.h>
@@ -17,8 +19,12 @@ struct sway_output *output_create(struct wlr_output *wlr_output) {
     node_init(&output->node, N_OUTPUT, output);
     output->wlr_output = wlr_output;
     wlr_output->data = output;
+    output_get_identifier(output->identifier, sizeof(output->identifier),
+        output);
     output->detected_subpixel = wlr_output->subpixel;
     output->scale_filter = SCALE_FILTER_NEAREST;
+    output_render_timing_init(output);
+    output->occluded_frame_interval = DEFAULT_OCCLUDED_FRAME_INTERVAL;
 
     wl_signal_init(&output->events.destroy);
 
@@ -43,6 +49,7 @@ void output_begin_destroy(struct sway_output *output) {
     output->node.destroying = true;
     node_set_dirty(&output->node);
 
+    output_frame_cache_finish(output);
     wl_list_remove(&output->link);
     output->wlr_output->data = NULL;
     output->wlr_output = NULL;
@@ -54,7 +61,7 @@ void output_enable(struct sway_output *output) {
     }
     output->windows = create_list();
     output->enabled = true;
-    list_add(wls->output_manager->outputs, output);
+    wls_output_index_push(&wls->output_manager->outputs, output);
 
     if (!output->active) {
         sway_log(SWAY_DEBUG, "Activating output '%s'", output->wlr_output->name);
@@ -108,9 +115,9 @@ static void output_evacuate(struct sway_output *output) {
 
 static void untrack_output(struct wls_window *win, void *data) {
     struct sway_output *output = data;
-    int index = list_find(win->outputs, output);
+    int index = wls_output_vec_find(&win->outputs, output);
     if (index != -1) {
-        list_del(win->outputs, index);
+        wls_output_vec_remove(&win->outputs, index);
     }
 }
 
@@ -125,7 +132,7 @@ void output_disable(struct sway_output *output) {
     if (!sway_assert(output->enabled, "Expected an enabled output")) {
         return;
     }
-    int index = list_find(wls->output_manager->outputs, output);
+    int index = wls_output_index_find(&wls->output_manager->outputs, output);
     if (!sway_assert(index >= 0, "Output not found in root node")) {
         return;
     }
@@ -138,10 +145,12 @@ void output_disable(struct sway_output *output) {
 
     wls_output_layout_for_each_window(untrack_output, output);
 
-    list_del(wls->output_manager->outputs, index);
+    wls_output_index_swap_remove(&wls->output_manager->outputs, index);
 
     output->enabled = false;
     output->current_mode = NULL;
+    // Arrange it from scratch if it comes back
+    output->arranged = false;
 
     wl_signal_emit(&wls->output_manager->events.output_disconnected, output);
 }
@@ -163,13 +172,21 @@ void output_destroy(struct sway_output *output) {
     wl_event_source_remove(output->repaint_timer);
     list_free(output->windows);
     list_free(output->current.windows);
+    free_output_config(output->config);
     free(output);
 }
 
+bool output_adaptive_sync_active(struct sway_output *output) {
+    return output->wlr_output->adaptive_sync_status ==
+        WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED;
+}
+
 void output_damage_whole(struct sway_output *output) {
     // The output can exist with no wlr_output if it's just been disconnected
     // and the transaction to evacuate it has't completed yet.
     if (output && output->wlr_output && output->damage) {
+        output->scene_damaged = true;
+        output_latency_note_damage(output);
         wlr_output_damage_add_whole(output->damage);
     }
 }
@@ -217,6 +234,51 @@ void output_get_box(struct sway_output *output, struct wlr_box *box) {
     box->height = output->height;
 }
 
+uint32_t output_get_changes(struct sway_output *output) {
+    if (!output->arranged) {
+        return WLS_OUTPUT_CHANGED_ALL;
+    }
+    uint32_t changes = output->changes;
+    struct wlr_box *box = wlr_output_layout_get_box(
+        wls->output_manager->output_layout, output->wlr_output);
+    if (box) {
+        if (box->x != output->arranged_box.x ||
+                box->y != output->arranged_box.y) {
+            changes |= WLS_OUTPUT_CHANGED_POSITION;
+        }
+        if (box->width != output->arranged_box.width ||
+                box->height != output->arranged_box.height) {
+            changes |= WLS_OUTPUT_CHANGED_SIZE;
+        }
+    }
+    if (memcmp(&output->usable_area, &output->arranged_usable_area,
+            sizeof(struct wlr_box)) != 0) {
+        changes |= WLS_OUTPUT_CHANGED_USABLE_AREA;
+    }
+    return changes;
+}
+
+void output_set_arranged(struct sway_output *output) {
+    struct wlr_box *box = wlr_output_layout_get_box(
+        wls->output_manager->output_layout, output->wlr_output);
+    if (box) {
+        output->arranged_box = *box;
+    }
+    output->arranged_usable_area = output->usable_area;
+    output->changes = 0;
+    output->arranged = true;
+}
+
+void wls_for_each_changed_output(wls_output_changes_func_t func, void *data) {
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
+        uint32_t changes = output_get_changes(output);
+        if (changes) {
+            func(output, changes, data);
+        }
+    }
+}
+
 struct wls_window *output_add_window(struct sway_output *output,
         struct wls_window *win) {
     if (win->output) {
@@ -224,6 +286,7 @@ struct wls_window *output_add_window(struct sway_output *output,
     }
     list_add(output->windows, win);
     win->output = output;
+    output->changes |= WLS_OUTPUT_CHANGED_WINDOWS;
     node_set_dirty(&win->node);
     return win;
 }
@@ -233,11 +296,9 @@ bool output_has_windows(struct sway_output *output) {
 }
 
 struct sway_output *output_by_name_or_id(const char *name_or_id) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
-        char identifier[128];
-        output_get_identifier(identifier, sizeof(identifier), output);
-        if (strcasecmp(identifier, name_or_id) == 0
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
+        if (strcasecmp(output->identifier, name_or_id) == 0
                 || strcasecmp(output->wlr_output->name, name_or_id) == 0) {
             return output;
         }
@@ -248,9 +309,7 @@ struct sway_output *output_by_name_or_id(const char *name_or_id) {
 struct sway_output *all_output_by_name_or_id(const char *name_or_id) {
     struct sway_output *output;
     wl_list_for_each(output, &wls->output_manager->all_outputs, link) {
-        char identifier[128];
-        output_get_identifier(identifier, sizeof(identifier), output);
-        if (strcasecmp(identifier, name_or_id) == 0
+        if (strcasecmp(output->identifier, name_or_id) == 0
                 || strcasecmp(output->wlr_output->name, name_or_id) == 0) {
             return output;
         }
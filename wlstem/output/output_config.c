@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_OUTPUT
 #include <assert.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -13,6 +14,7 @@
 #include "output_manager.h"
 #include "output.h"
 #include "log.h"
+#include "trace.h"
 #include "util.h"
 #include "wlstem.h"
 
@@ -66,6 +68,8 @@ struct output_config *new_output_config(const char *name) {
     oc->subpixel = WL_OUTPUT_SUBPIXEL_UNKNOWN;
     oc->max_render_time = -1;
     oc->adaptive_sync = -1;
+    oc->auto_frame_delay = -1;
+    oc->occluded_frame_interval = -1;
     return oc;
 }
 
@@ -119,6 +123,12 @@ void merge_output_config(struct output_config *dst, struct output_config *src) {
     if (src->adaptive_sync != -1) {
         dst->adaptive_sync = src->adaptive_sync;
     }
+    if (src->auto_frame_delay != -1) {
+        dst->auto_frame_delay = src->auto_frame_delay;
+    }
+    if (src->occluded_frame_interval != -1) {
+        dst->occluded_frame_interval = src->occluded_frame_interval;
+    }
     if (src->background) {
         free(dst->background);
         dst->background = strdup(src->background);
@@ -148,12 +158,12 @@ static void merge_wildcard_on_all(struct output_config *wildcard) {
 
 static void merge_id_on_name(struct output_config *oc) {
     char *id_on_name = NULL;
-    char id[128];
+    const char *id = NULL;
     char *name = NULL;
     struct sway_output *output;
     wl_list_for_each(output, &wls->output_manager->all_outputs, link) {
         name = output->wlr_output->name;
-        output_get_identifier(id, sizeof(id), output);
+        id = output->identifier;
         if (strcmp(name, oc->name) == 0 || strcmp(id, oc->name) == 0) {
             size_t length = snprintf(NULL, 0, "%s on %s", id, name) + 1;
             id_on_name = malloc(length);
@@ -203,6 +213,7 @@ static void merge_id_on_name(struct output_config *oc) {
 }
 
 struct output_config *store_output_config(struct output_config *oc) {
+    wls->output_configs_generation++;
     bool wildcard = strcmp(oc->name, "*") == 0;
     if (wildcard) {
         merge_wildcard_on_all(oc);
@@ -420,14 +431,26 @@ bool apply_output_config(struct output_config *oc, struct sway_output *output) {
         output->current_mode = wlr_output->pending.mode;
     }
 
-    sway_log(SWAY_DEBUG, "Committing output %s", wlr_output->name);
-    if (!wlr_output_commit(wlr_output)) {
-        // Failed to commit output changes, maybe the output is missing a CRTC.
-        // Leave the output disabled for now and try again when the output gets
-        // the mode we asked for.
-        sway_log(SWAY_ERROR, "Failed to commit output %s", wlr_output->name);
-        output->enabling = false;
-        return false;
+    // An output that already is in the requested state doesn't need a
+    // modeset, which matters when other outputs are configured along with it
+    if (output->enabled && wlr_output->pending.committed == 0) {
+        sway_log(SWAY_DEBUG, "Output %s is unchanged, not committing",
+            wlr_output->name);
+    } else {
+        sway_log(SWAY_DEBUG, "Committing output %s", wlr_output->name);
+        uint64_t start = wls_trace_now();
+        bool committed = wlr_output_commit(wlr_output);
+        wls->metrics.modesets++;
+        wls->metrics.modeset_usec += (wls_trace_now() - start) / 1000;
+        if (!committed) {
+            // Failed to commit output changes, maybe the output is missing a
+            // CRTC. Leave the output disabled for now and try again when the
+            // output gets the mode we asked for.
+            sway_log(SWAY_ERROR, "Failed to commit output %s",
+                wlr_output->name);
+            output->enabling = false;
+            return false;
+        }
     }
 
     output->enabling = false;
@@ -485,14 +508,60 @@ bool apply_output_config(struct output_config *oc, struct sway_output *output) {
         output_enable(output);
     }
 
-    if (oc && oc->max_render_time >= 0) {
+    if (oc && oc->max_render_time == MAX_RENDER_TIME_AUTO) {
+        sway_log(SWAY_DEBUG, "Set %s max render time to auto", oc->name);
+        output->render_timing.automatic = true;
+    } else if (oc && oc->max_render_time >= 0) {
         sway_log(SWAY_DEBUG, "Set %s max render time to %d",
             oc->name, oc->max_render_time);
+        output->render_timing.automatic = false;
         output->max_render_time = oc->max_render_time;
     }
+
+    if (oc && oc->auto_frame_delay != -1) {
+        sway_log(SWAY_DEBUG, "Set %s auto frame delay to %d",
+            oc->name, oc->auto_frame_delay);
+        output->auto_frame_delay = oc->auto_frame_delay == 1;
+    }
+
+    if (oc && oc->occluded_frame_interval >= 0) {
+        sway_log(SWAY_DEBUG, "Set %s occluded frame interval to %d",
+            oc->name, oc->occluded_frame_interval);
+        output->occluded_frame_interval = oc->occluded_frame_interval;
+    }
     return true;
 }
 
+struct output_config *current_output_config(struct sway_output *output) {
+    struct wlr_output *wlr_output = output->wlr_output;
+    struct output_config *oc = new_output_config(wlr_output->name);
+    if (!oc) {
+        return NULL;
+    }
+    oc->enabled = output->enabled;
+    if (!output->enabled) {
+        return oc;
+    }
+    if (wlr_output->current_mode) {
+        oc->width = wlr_output->current_mode->width;
+        oc->height = wlr_output->current_mode->height;
+        oc->refresh_rate = wlr_output->current_mode->refresh / 1000.f;
+        oc->custom_mode = 0;
+    } else {
+        oc->width = wlr_output->width;
+        oc->height = wlr_output->height;
+        oc->refresh_rate = wlr_output->refresh / 1000.f;
+        oc->custom_mode = 1;
+    }
+    oc->x = output->lx;
+    oc->y = output->ly;
+    oc->scale = wlr_output->scale;
+    oc->scale_filter = output->scale_filter;
+    oc->transform = wlr_output->transform;
+    oc->adaptive_sync = output_adaptive_sync_active(output);
+    return oc;
+}
+
 bool test_output_config(struct output_config *oc, struct sway_output *output) {
     if (output == wls->output_manager->noop_output) {
         return false;
@@ -504,7 +573,7 @@ bool test_output_config(struct output_config *oc, struct sway_output *output) {
     return ok;
 }
 
-static struct output_config *get_output_config(char *identifier,
+static struct output_config *get_output_config(const char *identifier,
         struct sway_output *sway_output) {
     const char *name = sway_output->wlr_output->name;
 
@@ -588,7 +657,15 @@ static struct output_config *get_output_config(char *identifier,
 }
 
 struct output_config *find_output_config(struct sway_output *output) {
-    char id[128];
-    output_get_identifier(id, sizeof(id), output);
-    return get_output_config(id, output);
+    if (output->config_generation != wls->output_configs_generation) {
+        free_output_config(output->config);
+        output->config = get_output_config(output->identifier, output);
+        output->config_generation = wls->output_configs_generation;
+    }
+    if (!output->config) {
+        return NULL;
+    }
+    struct output_config *oc = new_output_config(output->config->name);
+    merge_output_config(oc, output->config);
+    return oc;
 }
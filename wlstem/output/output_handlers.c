@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_OUTPUT
 #include <stdlib.h>
 #include <time.h>
 #include <wayland-server-core.h>
@@ -7,8 +8,12 @@
 #include <wlr/types/wlr_output_damage.h>
 #include <wlr/types/wlr_presentation_time.h>
 #include <wlr/types/wlr_output_power_management_v1.h>
+#include "cursor.h"
 #include "foreach.h"
+#include "latency.h"
 #include "log.h"
+#include "profile.h"
+#include "trace.h"
 #include "output.h"
 #include "output_config.h"
 #include "server.h"
@@ -20,34 +25,57 @@
 struct send_frame_done_data {
     struct timespec when;
     int msec_until_refresh;
+    int max_render_time;
+    uint64_t now_nsec, render_nsec; // in wls_trace_now() time
+    int throttled;
 };
 
 static void send_frame_done_iterator(struct sway_output *output, struct sway_view *view,
         struct wlr_surface *surface, struct wlr_box *box, float rotation,
         void *user_data) {
-    int view_max_render_time = 0;
-    if (view != NULL) {
-        view_max_render_time = view->max_render_time;
+    struct sway_surface *sway_surface = surface->data;
+    struct send_frame_done_data *data = user_data;
+
+    // Surfaces that weren't drawn in the last frame are covered, or showing
+    // a saved buffer. Don't let them render at full speed for nothing.
+    if (sway_surface->rendered_nsec < output->windows_render_nsec &&
+            output->occluded_frame_interval > 0) {
+        uint64_t interval_nsec =
+            (uint64_t)output->occluded_frame_interval * 1000000;
+        if (data->now_nsec - sway_surface->frame_done_sent_nsec <
+                interval_nsec) {
+            data->throttled++;
+            return;
+        }
+        surface_send_frame_done(sway_surface, &data->when);
+        return;
     }
 
-    struct send_frame_done_data *data = user_data;
+    // Time the client needs to render, configured or measured
+    int client_render_time = 0;
+    if (view != NULL && view->max_render_time != 0) {
+        client_render_time = view->max_render_time;
+    } else if (output->auto_frame_delay) {
+        client_render_time = surface_get_commit_time(sway_surface);
+    }
 
-    int delay = data->msec_until_refresh - output->max_render_time
-            - view_max_render_time;
+    int delay = data->msec_until_refresh - data->max_render_time
+            - client_render_time;
 
-    if (output->max_render_time == 0 || view_max_render_time == 0 || delay < 1) {
-        wlr_surface_send_frame_done(surface, &data->when);
+    if (data->max_render_time == 0 || client_render_time <= 0 || delay < 1) {
+        surface_send_frame_done(sway_surface, &data->when);
     } else {
-        struct sway_surface *sway_surface = surface->data;
-        wl_event_source_timer_update(sway_surface->frame_done_timer, delay);
+        surface_schedule_frame_done(sway_surface, delay, data->render_nsec);
     }
 }
 
 static void send_frame_done(struct sway_output *output, struct send_frame_done_data *data) {
+    WLS_TRACE_SCOPE("send_frame_done");
     output_for_each_surface(output, send_frame_done_iterator, data);
 }
 
 static int output_repaint_timer_handler(void *data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_output *output = data;
     if (output->wlr_output == NULL) {
         return 0;
@@ -73,6 +101,7 @@ static int output_repaint_timer_handler(void *data) {
 
         output_render(output, &now, &damage);
     } else {
+        output->metrics.frames_skipped++;
         wlr_output_rollback(output->wlr_output);
     }
 
@@ -97,24 +126,39 @@ static void damage_handle_destroy(struct wl_listener *listener, void *data) {
 }
 
 static void damage_handle_frame(struct wl_listener *listener, void *user_data) {
+    WLS_PROFILE_CALLBACK();
     struct sway_output *output =
         wl_container_of(listener, output, damage_frame);
     if (!output->enabled || !output->wlr_output->enabled) {
         return;
     }
 
+    // The previous frame may have been skipped, or failed to commit. Its
+    // deadline must not be charged to the next commit, which can come much
+    // later after an idle period.
+    output_render_timing_cancel(output);
+
     // Compute predicted milliseconds until the next refresh. It's used for
     // delaying both output rendering and surface frame callbacks.
+    //
+    // With adaptive sync, the panel refreshes when a frame arrives instead
+    // of at a predictable time, so there is nothing to wait for: render and
+    // let clients draw right away. Page flips still keep us under the
+    // maximum refresh rate, and the panel repeats the last frame when
+    // nothing comes before its minimum rate.
     int msec_until_refresh = 0;
+    int max_render_time = output_adaptive_sync_active(output) ?
+        0 : output_get_max_render_time(output);
+    struct timespec predicted_refresh = {0};
 
-    if (output->max_render_time != 0) {
+    if (max_render_time != 0) {
         struct timespec now;
         clockid_t presentation_clock
             = wlr_backend_get_presentation_clock(wls->server->backend);
         clock_gettime(presentation_clock, &now);
 
         const long NSEC_IN_SECONDS = 1000000000;
-        struct timespec predicted_refresh = output->last_presentation;
+        predicted_refresh = output->last_presentation;
         predicted_refresh.tv_nsec += output->refresh_nsec % NSEC_IN_SECONDS;
         predicted_refresh.tv_sec += output->refresh_nsec / NSEC_IN_SECONDS;
         if (predicted_refresh.tv_nsec >= NSEC_IN_SECONDS) {
@@ -143,13 +187,14 @@ static void damage_handle_frame(struct wl_listener *listener, void *user_data) {
         }
     }
 
-    int delay = msec_until_refresh - output->max_render_time;
+    int delay = msec_until_refresh - max_render_time;
 
     // If the delay is less than 1 millisecond (which is the least we can wait)
     // then just render right away.
     if (delay < 1) {
         output_repaint_timer_handler(output);
     } else {
+        output_render_timing_schedule(output, &predicted_refresh);
         output->wlr_output->frame_pending = true;
         wl_event_source_timer_update(output->repaint_timer, delay);
     }
@@ -158,7 +203,13 @@ static void damage_handle_frame(struct wl_listener *listener, void *user_data) {
     struct send_frame_done_data data = {0};
     clock_gettime(CLOCK_MONOTONIC, &data.when);
     data.msec_until_refresh = msec_until_refresh;
+    data.max_render_time = max_render_time;
+    data.now_nsec = wls_trace_now();
+    data.render_nsec =
+        data.now_nsec + (uint64_t)(delay > 0 ? delay : 0) * 1000000;
     send_frame_done(output, &data);
+    output->metrics.frame_done_throttled += data.throttled;
+    output->metrics.surfaces_throttled = data.throttled;
 }
 
 static void handle_destroy(struct wl_listener *listener, void *data) {
@@ -206,6 +257,7 @@ static void handle_mode(struct wl_listener *listener, void *data) {
 }
 
 static void handle_commit(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK_NAMED("output_handle_commit");
     struct sway_output *output = wl_container_of(listener, output, commit);
     struct wlr_output_event_commit *event = data;
 
@@ -213,6 +265,7 @@ static void handle_commit(struct wl_listener *listener, void *data) {
 }
 
 static void handle_present(struct wl_listener *listener, void *data) {
+    WLS_PROFILE_CALLBACK_NAMED("output_handle_present");
     struct sway_output *output = wl_container_of(listener, output, present);
     struct wlr_output_event_present *output_event = data;
 
@@ -220,8 +273,22 @@ static void handle_present(struct wl_listener *listener, void *data) {
         return;
     }
 
+    if (output->last_presentation.tv_sec || output->last_presentation.tv_nsec) {
+        int64_t interval_usec = (int64_t)(output_event->when->tv_sec -
+                output->last_presentation.tv_sec) * 1000000 +
+            (output_event->when->tv_nsec -
+                output->last_presentation.tv_nsec) / 1000;
+        wls_latency_histogram_add(&output->metrics.frame_interval[
+            output_adaptive_sync_active(output)], interval_usec);
+    }
+
     output->last_presentation = *output_event->when;
     output->refresh_nsec = output_event->refresh;
+
+    output_latency_handle_present(output, output_event->commit_seq,
+        output_event->when);
+    output_render_timing_handle_present(output, output_event->commit_seq,
+        output_event->when, output_event->refresh);
 }
 
 void handle_new_output(struct wl_listener *listener, void *data) {
@@ -279,6 +346,7 @@ void handle_output_power_manager_set_mode(struct wl_listener *listener,
 
 void handle_output_layout_change(struct wl_listener *listener,
         void *data) {
+    cursor_invalidate_all_touch_points();
     wls_update_output_manager_config(wls->output_manager);
     wl_signal_emit(&wls->output_manager->events.output_layout_changed, wls->output_manager);
 }
@@ -1,4 +1,6 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_OUTPUT
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,12 +12,70 @@
 #include "output_manager.h"
 #include "list.h"
 #include "log.h"
+#include "trace.h"
 #include "util.h"
 #include "window.h"
 #include "wlstem.h"
 #include "server.h"
 
-void wls_update_output_manager_config(struct wls_output_manager *output_manager) {
+// The parts of a configuration head that clients see
+struct wls_output_head_state {
+    struct wlr_output *output;
+    bool enabled;
+    struct wlr_output_mode *mode;
+    int32_t custom_width, custom_height, custom_refresh;
+    int32_t x, y;
+    enum wl_output_transform transform;
+    float scale;
+};
+
+static void get_head_state(struct wls_output_head_state *state,
+        struct wlr_output_configuration_head_v1 *config_head) {
+    memset(state, 0, sizeof(*state));
+    state->output = config_head->state.output;
+    state->enabled = config_head->state.enabled;
+    state->mode = config_head->state.mode;
+    state->custom_width = config_head->state.custom_mode.width;
+    state->custom_height = config_head->state.custom_mode.height;
+    state->custom_refresh = config_head->state.custom_mode.refresh;
+    state->x = config_head->state.x;
+    state->y = config_head->state.y;
+    state->transform = config_head->state.transform;
+    state->scale = config_head->state.scale;
+}
+
+/**
+ * Replace the last sent heads with those of `config`, and return whether
+ * they changed.
+ */
+static bool update_sent_heads(struct wls_output_manager *output_manager,
+        struct wlr_output_configuration_v1 *config) {
+    int length = wl_list_length(&config->heads);
+    struct wls_output_head_state *heads =
+        calloc(length, sizeof(struct wls_output_head_state));
+    if (length > 0 && !heads) {
+        sway_log(SWAY_ERROR, "Unable to allocate output head states");
+        return true;
+    }
+    int i = 0;
+    struct wlr_output_configuration_head_v1 *config_head;
+    wl_list_for_each(config_head, &config->heads, link) {
+        get_head_state(&heads[i++], config_head);
+    }
+
+    bool changed = length != output_manager->sent_heads_length ||
+        (length > 0 && memcmp(heads, output_manager->sent_heads,
+            sizeof(struct wls_output_head_state) * length) != 0);
+    free(output_manager->sent_heads);
+    output_manager->sent_heads = heads;
+    output_manager->sent_heads_length = length;
+    return changed;
+}
+
+static void send_output_manager_config(void *data) {
+    struct wls_output_manager *output_manager = data;
+    output_manager->config_idle = NULL;
+
     struct wlr_output_configuration_v1 *config =
         wlr_output_configuration_v1_create();
 
@@ -37,31 +97,133 @@ void wls_update_output_manager_config(struct wls_output_manager *output_manager)
         }
     }
 
+    if (!update_sent_heads(output_manager, config)) {
+        sway_log(SWAY_DEBUG, "Output configuration unchanged, not sending it");
+        wlr_output_configuration_v1_destroy(config);
+        return;
+    }
     wlr_output_manager_v1_set_configuration(output_manager->output_manager_v1, config);
 }
 
+void wls_update_output_manager_config(struct wls_output_manager *output_manager) {
+    if (output_manager->config_idle) {
+        return;
+    }
+    output_manager->config_idle = wl_event_loop_add_idle(
+        wls->server->wl_event_loop, send_output_manager_config,
+        output_manager);
+    if (!output_manager->config_idle) {
+        send_output_manager_config(output_manager);
+    }
+}
+
+struct staged_output_config {
+    struct sway_output *output;
+    struct output_config *head; // what the client asked for, to store
+    struct output_config *oc; // effective config, to apply
+    struct output_config *previous; // to roll back to, once applied
+};
+
+/**
+ * Stage the head config on top of the effective config of the output, so
+ * that settings the protocol doesn't carry (scale filter, adaptive sync,
+ * subpixel, max render time, dpms) are kept. Takes ownership of head.
+ */
+static void stage_output_config(struct staged_output_config *stage,
+        struct sway_output *output, struct output_config *head) {
+    stage->output = output;
+    stage->head = head;
+    stage->oc = find_output_config(output);
+    if (!stage->oc) {
+        stage->oc = new_output_config(output->wlr_output->name);
+    }
+    merge_output_config(stage->oc, head);
+}
+
+static struct output_config *output_config_from_head(
+        struct wlr_output_configuration_head_v1 *config_head) {
+    struct output_config *oc =
+        new_output_config(config_head->state.output->name);
+    oc->enabled = true;
+    if (config_head->state.mode != NULL) {
+        struct wlr_output_mode *mode = config_head->state.mode;
+        oc->width = mode->width;
+        oc->height = mode->height;
+        oc->refresh_rate = mode->refresh / 1000.f;
+    } else {
+        oc->width = config_head->state.custom_mode.width;
+        oc->height = config_head->state.custom_mode.height;
+        oc->refresh_rate =
+            config_head->state.custom_mode.refresh / 1000.f;
+    }
+    oc->x = config_head->state.x;
+    oc->y = config_head->state.y;
+    oc->transform = config_head->state.transform;
+    oc->scale = config_head->state.scale;
+    return oc;
+}
+
+/**
+ * Apply the staged configs in order, stopping at the first failure. The
+ * outputs configured until then are brought back to their previous state.
+ */
+static bool apply_staged_output_configs(struct staged_output_config *staged,
+        int length) {
+    int applied = 0;
+    for (; applied < length; ++applied) {
+        struct staged_output_config *stage = &staged[applied];
+        stage->previous = current_output_config(stage->output);
+        if (!apply_output_config(stage->oc, stage->output)) {
+            break;
+        }
+    }
+    if (applied == length) {
+        return true;
+    }
+
+    sway_log(SWAY_ERROR, "Failed to apply the configuration of %s, "
+        "rolling back %d outputs", staged[applied].output->wlr_output->name,
+        applied);
+    for (int i = applied; i >= 0; --i) {
+        struct staged_output_config *stage = &staged[i];
+        if (stage->previous && !apply_output_config(stage->previous,
+                stage->output)) {
+            sway_log(SWAY_ERROR, "Failed to restore the configuration of %s",
+                stage->output->wlr_output->name);
+        }
+    }
+    return false;
+}
+
 static void output_manager_apply(struct wls_output_manager *output_manager,
         struct wlr_output_configuration_v1 *config, bool test_only) {
-    // TODO: perform atomic tests on the whole backend atomically
+    // wlroots can only test and commit outputs one at a time. Stage the whole
+    // configuration first, then apply it in one go, so that it either applies
+    // as a whole or not at all, and configs are only stored once it did.
+    int length = wl_list_length(&config->heads);
+    struct staged_output_config *staged =
+        calloc(length, sizeof(struct staged_output_config));
+    if (length > 0 && !staged) {
+        sway_log(SWAY_ERROR, "Unable to allocate the staged configuration");
+        wlr_output_configuration_v1_send_failed(config);
+        wlr_output_configuration_v1_destroy(config);
+        return;
+    }
 
     struct wlr_output_configuration_head_v1 *config_head;
-    // First disable outputs we need to disable
-    bool ok = true;
+    int n = 0;
+    // First disable outputs we need to disable, freeing their CRTCs
     wl_list_for_each(config_head, &config->heads, link) {
         struct wlr_output *wlr_output = config_head->state.output;
         struct sway_output *output = wlr_output->data;
         if (!output->enabled || config_head->state.enabled) {
             continue;
         }
-        struct output_config *oc = new_output_config(output->wlr_output->name);
-        oc->enabled = false;
-
-        if (test_only) {
-            ok &= test_output_config(oc, output);
-        } else {
-            oc = store_output_config(oc);
-            ok &= apply_output_config(oc, output);
-        }
+        struct output_config *head =
+            new_output_config(output->wlr_output->name);
+        head->enabled = false;
+        stage_output_config(&staged[n], output, head);
+        n++;
     }
 
     // Then enable outputs that need to
@@ -71,31 +233,36 @@ static void output_manager_apply(struct wls_output_manager *output_manager,
         if (!config_head->state.enabled) {
             continue;
         }
-        struct output_config *oc = new_output_config(output->wlr_output->name);
-        oc->enabled = true;
-        if (config_head->state.mode != NULL) {
-            struct wlr_output_mode *mode = config_head->state.mode;
-            oc->width = mode->width;
-            oc->height = mode->height;
-            oc->refresh_rate = mode->refresh / 1000.f;
-        } else {
-            oc->width = config_head->state.custom_mode.width;
-            oc->height = config_head->state.custom_mode.height;
-            oc->refresh_rate =
-                config_head->state.custom_mode.refresh / 1000.f;
+        stage_output_config(&staged[n], output,
+            output_config_from_head(config_head));
+        n++;
+    }
+
+    bool ok = true;
+    if (test_only) {
+        for (int i = 0; i < n; ++i) {
+            ok &= test_output_config(staged[i].oc, staged[i].output);
         }
-        oc->x = config_head->state.x;
-        oc->y = config_head->state.y;
-        oc->transform = config_head->state.transform;
-        oc->scale = config_head->state.scale;
+    } else {
+        uint64_t start = wls_trace_now();
+        uint64_t modesets = wls->metrics.modesets;
+        ok = apply_staged_output_configs(staged, n);
+        sway_log(SWAY_INFO, "%s the configuration of %d outputs with %"
+            PRIu64 " modesets in %.1f ms", ok ? "Applied" : "Failed to apply",
+            n, wls->metrics.modesets - modesets,
+            (wls_trace_now() - start) / 1e6);
+    }
 
-        if (test_only) {
-            ok &= test_output_config(oc, output);
+    for (int i = 0; i < n; ++i) {
+        if (ok && !test_only) {
+            store_output_config(staged[i].head);
         } else {
-            oc = store_output_config(oc);
-            ok &= apply_output_config(oc, output);
+            free_output_config(staged[i].head);
         }
+        free_output_config(staged[i].oc);
+        free_output_config(staged[i].previous);
     }
+    free(staged);
 
     if (ok) {
         wlr_output_configuration_v1_send_succeeded(config);
@@ -137,7 +304,6 @@ struct wls_output_manager *wls_output_manager_create(struct wls_server *server)
     wl_list_init(&output_manager->xwayland_unmanaged);
 #endif
     wl_list_init(&output_manager->drag_icons);
-    output_manager->outputs = create_list();
 
     output_manager->new_output.notify = handle_new_output;
     wl_signal_add(&server->backend->events.new_output, &output_manager->new_output);
@@ -161,7 +327,9 @@ struct wls_output_manager *wls_output_manager_create(struct wls_server *server)
 }
 
 void wls_output_manager_destroy(struct wls_output_manager *output_manager) {
-    list_free(output_manager->outputs);
+    // A pending config_idle went away with the event loop
+    free(output_manager->sent_heads);
+    wls_output_index_finish(&output_manager->outputs);
     wlr_output_layout_destroy(output_manager->output_layout);
     free(output_manager);
 }
@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_OUTPUT
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <wlr/types/wlr_output.h>
+#include "log.h"
+#include "output.h"
+#include "render_timing.h"
+
+// Samples needed before rendering is delayed at all
+#define MIN_SAMPLES 8
+// Percentile of the render durations to plan for
+#define ESTIMATE_PERCENTILE 95
+
+#define MIN_MARGIN_USEC 1000
+#define MAX_MARGIN_USEC 8000
+// Deadlines met in a row before the margin is reduced again
+#define MARGIN_DECAY_FRAMES 120
+
+void output_render_timing_init(struct sway_output *output) {
+    struct wls_output_render_timing *timing = &output->render_timing;
+    memset(timing, 0, sizeof(*timing));
+    timing->automatic = true;
+    timing->margin_usec = MIN_MARGIN_USEC;
+}
+
+static void update_estimate(struct wls_output_render_timing *timing) {
+    uint32_t sorted[WLS_RENDER_TIMING_SAMPLES];
+    int n = timing->samples_length;
+    memcpy(sorted, timing->samples_usec, sizeof(uint32_t) * n);
+    for (int i = 1; i < n; ++i) {
+        uint32_t value = sorted[i];
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > value; --j) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+    timing->estimate_usec = sorted[(n * ESTIMATE_PERCENTILE - 1) / 100];
+    timing->estimate_stale = false;
+}
+
+int output_get_max_render_time(struct sway_output *output) {
+    struct wls_output_render_timing *timing = &output->render_timing;
+    if (!timing->automatic) {
+        return output->max_render_time;
+    }
+    if (timing->samples_length < MIN_SAMPLES) {
+        return 0;
+    }
+    if (timing->estimate_stale) {
+        update_estimate(timing);
+    }
+    // Round up, the repaint timer only has millisecond precision
+    return (timing->estimate_usec + timing->margin_usec + 999) / 1000;
+}
+
+void output_render_timing_add_sample(struct sway_output *output,
+        uint32_t usec) {
+    struct wls_output_render_timing *timing = &output->render_timing;
+    timing->samples_usec[timing->samples_next] = usec;
+    timing->samples_next =
+        (timing->samples_next + 1) % WLS_RENDER_TIMING_SAMPLES;
+    if (timing->samples_length < WLS_RENDER_TIMING_SAMPLES) {
+        timing->samples_length++;
+    }
+    timing->estimate_stale = true;
+}
+
+void output_render_timing_schedule(struct sway_output *output,
+        const struct timespec *deadline) {
+    struct wls_output_render_timing *timing = &output->render_timing;
+    timing->scheduled = true;
+    timing->scheduled_deadline = *deadline;
+}
+
+void output_render_timing_cancel(struct sway_output *output) {
+    output->render_timing.scheduled = false;
+}
+
+void output_render_timing_handle_commit(struct sway_output *output) {
+    struct wls_output_render_timing *timing = &output->render_timing;
+    // Frames rendered right away have no deadline to miss
+    timing->commit_pending = timing->scheduled;
+    timing->commit_seq = output->wlr_output->commit_seq;
+    timing->commit_deadline = timing->scheduled_deadline;
+    timing->scheduled = false;
+}
+
+void output_render_timing_handle_present(struct sway_output *output,
+        uint32_t commit_seq, const struct timespec *when,
+        uint32_t refresh_nsec) {
+    struct wls_output_render_timing *timing = &output->render_timing;
+    if (!timing->commit_pending || commit_seq != timing->commit_seq) {
+        return;
+    }
+    timing->commit_pending = false;
+    if (!when || refresh_nsec == 0) {
+        return;
+    }
+
+    // Anything presented half a refresh or more after the deadline made it
+    // only on a later refresh
+    int64_t late_nsec =
+        (int64_t)(when->tv_sec - timing->commit_deadline.tv_sec) * 1000000000 +
+        (when->tv_nsec - timing->commit_deadline.tv_nsec);
+    if (late_nsec < refresh_nsec / 2) {
+        if (++timing->deadlines_met >= MARGIN_DECAY_FRAMES &&
+                timing->margin_usec > MIN_MARGIN_USEC) {
+            timing->margin_usec -= timing->margin_usec / 4;
+            if (timing->margin_usec < MIN_MARGIN_USEC) {
+                timing->margin_usec = MIN_MARGIN_USEC;
+            }
+            timing->deadlines_met = 0;
+        }
+        return;
+    }
+
+    output->metrics.frames_missed++;
+    timing->deadlines_met = 0;
+    if (timing->automatic && timing->margin_usec < MAX_MARGIN_USEC) {
+        timing->margin_usec *= 2;
+        if (timing->margin_usec > MAX_MARGIN_USEC) {
+            timing->margin_usec = MAX_MARGIN_USEC;
+        }
+        sway_log(SWAY_DEBUG, "%s missed a refresh, render margin is now "
+            "%.1f ms", output->wlr_output->name, timing->margin_usec / 1000.0);
+    }
+}
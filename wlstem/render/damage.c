@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_DAMAGE
 #include <string.h>
 #include <wlr/types/wlr_box.h>
 #include <wlr/types/wlr_output_damage.h>
@@ -10,6 +11,11 @@
 #include "window.h"
 #include "wlstem.h"
 
+static void note_scene_damage(struct sway_output *output) {
+    output->scene_damaged = true;
+    output_latency_note_damage(output);
+}
+
 static void damage_surface_iterator(struct sway_output *output, struct sway_view *view,
         struct wlr_surface *surface, struct wlr_box *_box, float rotation,
         void *_data) {
@@ -36,12 +42,14 @@ static void damage_surface_iterator(struct sway_output *output, struct sway_view
         pixman_region32_translate(&damage, box.x, box.y);
         wlr_region_rotated_bounds(&damage, &damage, rotation,
             center_x, center_y);
+        note_scene_damage(output);
         wlr_output_damage_add(output->damage, &damage);
         pixman_region32_fini(&damage);
     }
 
     if (whole) {
         wlr_box_rotated_bounds(&box, &box, rotation);
+        note_scene_damage(output);
         wlr_output_damage_add_box(output->damage, &box);
     }
 
@@ -62,15 +70,15 @@ static void damage_child_views_iterator(struct wls_window *win,
 }
 
 void view_damage_from(struct sway_view *view) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         output_damage_from_view(output, view);
     }
 }
 
 void window_damage_whole(struct wls_window *window) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         output_damage_whole_window(output, window);
     }
 }
@@ -81,6 +89,7 @@ void output_damage_box(struct sway_output *output, struct wlr_box *_box) {
     box.x -= output->lx;
     box.y -= output->ly;
     scale_box(&box, output->wlr_output->scale);
+    note_scene_damage(output);
     wlr_output_damage_add_box(output->damage, &box);
 }
 
@@ -94,6 +103,7 @@ void output_damage_whole_window(struct sway_output *output,
         .height = win->current.height + 2,
     };
     scale_box(&box, output->wlr_output->scale);
+    note_scene_damage(output);
     wlr_output_damage_add_box(output->damage, &box);
     // Damage subsurfaces as well, which may extend outside the box
     if (win->view) {
@@ -118,8 +128,8 @@ void output_damage_from_view(struct sway_output *output,
 
 void desktop_damage_surface(struct wlr_surface *surface, double lx, double ly,
         bool whole) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         struct wlr_box *output_box = wlr_output_layout_get_box(
             wls->output_manager->output_layout, output->wlr_output);
         output_damage_surface(output, lx - output_box->x,
@@ -128,15 +138,15 @@ void desktop_damage_surface(struct wlr_surface *surface, double lx, double ly,
 }
 
 void desktop_damage_whole_window(struct wls_window *win) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         output_damage_whole_window(output, win);
     }
 }
 
 void desktop_damage_box(struct wlr_box *box) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         output_damage_box(output, box);
     }
 }
@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_OUTPUT
+#include <GLES2/gl2.h>
+#include <wayland-server-core.h>
+#include <wlr/backend.h>
+#include <wlr/render/gles2.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/render/wlr_texture.h>
+#include <wlr/types/wlr_matrix.h>
+#include <wlr/types/wlr_output.h>
+#include "frame_cache.h"
+#include "log.h"
+#include "output.h"
+#include "render.h"
+#include "wlstem.h"
+
+static bool output_cacheable(struct sway_output *output) {
+    return wls->debug.frame_cache && !output->frame_cache.failed &&
+        output->wlr_output->transform == WL_OUTPUT_TRANSFORM_NORMAL &&
+        wls->debug.damage == DAMAGE_DEFAULT;
+}
+
+void output_frame_cache_finish(struct sway_output *output) {
+    struct wls_output_frame_cache *cache = &output->frame_cache;
+    if (cache->texture) {
+        wlr_texture_destroy(cache->texture);
+        cache->texture = NULL;
+    }
+    cache->valid = false;
+}
+
+static bool cache_matches(struct sway_output *output) {
+    struct wls_output_frame_cache *cache = &output->frame_cache;
+    return cache->texture && cache->width == output->wlr_output->width &&
+        cache->height == output->wlr_output->height &&
+        cache->scale == output->wlr_output->scale;
+}
+
+bool output_frame_cache_usable(struct sway_output *output) {
+    return output->frame_cache.valid && output_cacheable(output) &&
+        cache_matches(output);
+}
+
+void output_frame_cache_prepare(struct sway_output *output,
+        pixman_region32_t *damage) {
+    if (!output_frame_cache_usable(output) && output_cacheable(output)) {
+        pixman_region32_union_rect(damage, damage, 0, 0,
+            output->wlr_output->width, output->wlr_output->height);
+    }
+}
+
+static bool ensure_texture(struct sway_output *output) {
+    struct wls_output_frame_cache *cache = &output->frame_cache;
+    struct wlr_output *wlr_output = output->wlr_output;
+    if (cache->texture && cache->width == wlr_output->width &&
+            cache->height == wlr_output->height) {
+        return true;
+    }
+    output_frame_cache_finish(output);
+
+    struct wlr_renderer *renderer =
+        wlr_backend_get_renderer(wlr_output->backend);
+    if (!wlr_renderer_is_gles2(renderer)) {
+        cache->failed = true;
+        return false;
+    }
+    // The contents are filled by the next full frame, so leave them undefined.
+    // XBGR8888 is the format that matches GL_RGBA, which glCopyTexSubImage2D
+    // can write to.
+    cache->texture = wlr_texture_from_pixels(renderer,
+        WL_SHM_FORMAT_XBGR8888, wlr_output->width * 4,
+        wlr_output->width, wlr_output->height, NULL);
+    if (!cache->texture) {
+        sway_log(SWAY_ERROR, "Unable to allocate the frame cache of %s",
+            wlr_output->name);
+        cache->failed = true;
+        return false;
+    }
+    cache->width = wlr_output->width;
+    cache->height = wlr_output->height;
+    return true;
+}
+
+void output_frame_cache_update(struct sway_output *output,
+        pixman_region32_t *damage) {
+    struct wls_output_frame_cache *cache = &output->frame_cache;
+    if (!output_cacheable(output)) {
+        cache->valid = false;
+        return;
+    }
+    if (!ensure_texture(output)) {
+        return;
+    }
+    if (cache->scale != output->wlr_output->scale) {
+        cache->scale = output->wlr_output->scale;
+        cache->valid = false;
+    }
+
+    // Don't blame the copy for errors left by someone else
+    while (glGetError() != GL_NO_ERROR) {
+        // Nothing to do
+    }
+
+    struct wlr_gles2_texture_attribs attribs;
+    wlr_gles2_texture_get_attribs(cache->texture, &attribs);
+    glBindTexture(attribs.target, attribs.tex);
+
+    // With an untransformed output, damage is in buffer coordinates. The GL
+    // framebuffer is bottom-up, so buffer row y is framebuffer row
+    // height - 1 - y. Rows are copied as they are, which leaves the cache
+    // bottom-up as well; output_frame_cache_render() flips it back.
+    int nrects;
+    pixman_box32_t *rects = pixman_region32_rectangles(damage, &nrects);
+    for (int i = 0; i < nrects; ++i) {
+        int gl_y = cache->height - rects[i].y2;
+        glCopyTexSubImage2D(attribs.target, 0, rects[i].x1, gl_y,
+            rects[i].x1, gl_y, rects[i].x2 - rects[i].x1,
+            rects[i].y2 - rects[i].y1);
+    }
+    glBindTexture(attribs.target, 0);
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        sway_log(SWAY_INFO, "Unable to copy the frame of %s (GL error 0x%x), "
+            "disabling its frame cache", output->wlr_output->name, error);
+        output_frame_cache_finish(output);
+        cache->failed = true;
+        return;
+    }
+
+    if (!cache->valid) {
+        pixman_box32_t whole = { 0, 0, cache->width, cache->height };
+        cache->valid = pixman_region32_contains_rectangle(damage, &whole) ==
+            PIXMAN_REGION_IN;
+    }
+}
+
+void output_frame_cache_render(struct sway_output *output,
+        pixman_region32_t *damage) {
+    struct wls_output_frame_cache *cache = &output->frame_cache;
+    struct wlr_output *wlr_output = output->wlr_output;
+    struct wlr_box box = { 0, 0, cache->width, cache->height };
+    float matrix[9];
+    // The cache holds the framebuffer rows bottom-up, see
+    // output_frame_cache_update()
+    wlr_matrix_project_box(matrix, &box, WL_OUTPUT_TRANSFORM_FLIPPED_180, 0,
+        wlr_output->transform_matrix);
+    render_texture(wlr_output, damage, cache->texture, NULL, &box, matrix,
+        1.0f);
+}
@@ -10,9 +10,12 @@
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_output_damage.h>
 #include <wlr/util/region.h>
+#include "latency.h"
 #include "log.h"
 #include "output.h"
 #include "output_config.h"
+#include "startup.h"
+#include "trace.h"
 #include "wlstem.h"
 
 void premultiply_alpha(float color[4], float opacity) {
@@ -140,8 +143,21 @@ damage_finish:
     pixman_region32_fini(&damage);
 }
 
+static uint64_t region_area(pixman_region32_t *region) {
+    int nrects;
+    pixman_box32_t *rects = pixman_region32_rectangles(region, &nrects);
+    uint64_t area = 0;
+    for (int i = 0; i < nrects; ++i) {
+        area += (uint64_t)(rects[i].x2 - rects[i].x1) *
+            (rects[i].y2 - rects[i].y1);
+    }
+    return area;
+}
+
 void output_render(struct sway_output *output, struct timespec *when,
         pixman_region32_t *damage) {
+    WLS_TRACE_SCOPE("output_render");
+    uint64_t start = wls_trace_now();
     struct wlr_output *wlr_output = output->wlr_output;
 
     struct wlr_renderer *renderer =
@@ -155,6 +171,11 @@ void output_render(struct sway_output *output, struct timespec *when,
         return;
     }
 
+    // If only software cursors moved, what's below them is in the cache
+    bool cursor_only =
+        !output->scene_damaged && output_frame_cache_usable(output);
+    output->scene_damaged = false;
+
     wlr_renderer_begin(renderer, wlr_output->width, wlr_output->height);
 
     if (!pixman_region32_not_empty(damage)) {
@@ -162,6 +183,11 @@ void output_render(struct sway_output *output, struct timespec *when,
         goto renderer_end;
     }
 
+    if (cursor_only) {
+        output_frame_cache_render(output, damage);
+        goto renderer_end;
+    }
+
     if (wls->debug.damage == DAMAGE_HIGHLIGHT) {
         wlr_renderer_clear(renderer, (float[]){1, 1, 0, 1});
     } else if (wls->debug.damage == DAMAGE_RERENDER) {
@@ -169,11 +195,19 @@ void output_render(struct sway_output *output, struct timespec *when,
         wlr_output_transformed_resolution(wlr_output, &width, &height);
         pixman_region32_union_rect(damage, damage, 0, 0, width, height);
     }
+    output_frame_cache_prepare(output, damage);
 
     if (!output_has_opaque_overlay_layer_surface(output)) {
+        output->windows_render_nsec = start;
+        uint64_t span = wls_trace_begin();
         wls->user_callbacks.output_render_non_overlay(output, renderer, damage);
+        wls_trace_end("output_render_non_overlay", span);
     }
+    uint64_t span = wls_trace_begin();
     wls->user_callbacks.output_render_overlay(output, renderer, damage);
+    wls_trace_end("output_render_overlay", span);
+
+    output_frame_cache_update(output, damage);
 
 renderer_end:
     wlr_renderer_scissor(renderer, NULL);
@@ -199,8 +233,26 @@ renderer_end:
     wlr_output_set_damage(wlr_output, &frame_damage);
     pixman_region32_fini(&frame_damage);
 
-    if (!wlr_output_commit(wlr_output)) {
+    uint64_t commit_span = wls_trace_begin();
+    bool committed = wlr_output_commit(wlr_output);
+    wls_trace_end("wlr_output_commit", commit_span);
+    if (!committed) {
+        // The damage is kept for the next frame, which must redraw it fully
+        output->scene_damaged = true;
         return;
     }
     output->last_frame = *when;
+    output->metrics.frames_rendered++;
+    output->metrics.damage_pixels += region_area(damage);
+    uint32_t render_usec = (wls_trace_now() - start) / 1000;
+    wls_latency_histogram_add(&output->metrics.render_time, render_usec);
+    if (cursor_only) {
+        output->metrics.frames_cursor_only++;
+    } else {
+        // Cheap frames would make the estimate too optimistic
+        output_render_timing_add_sample(output, render_usec);
+    }
+    output_render_timing_handle_commit(output);
+    output_latency_handle_commit(output);
+    wls_startup_first_frame();
 }
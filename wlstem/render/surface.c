@@ -4,14 +4,23 @@
 #include <wlr/types/wlr_surface.h>
 #include "sway_server.h"
 #include "surface.h"
+#include "trace.h"
 #include "wlstem.h"
 #include "server.h"
 
+// Commits later than this after frame done are not a reaction to it
+#define MAX_COMMIT_SAMPLE_USEC 100000
+// Samples needed before frame done is delayed according to them
+#define MIN_COMMIT_SAMPLES 4
+// Added to the slowest recent commit, to absorb scheduling jitter
+#define COMMIT_MARGIN_USEC 1000
+
 static void handle_destroy(struct wl_listener *listener, void *data) {
     struct sway_surface *surface = wl_container_of(listener, surface, destroy);
 
     surface->wlr_surface->data = NULL;
     wl_list_remove(&surface->destroy.link);
+    wl_list_remove(&surface->commit.link);
 
     if (surface->frame_done_timer) {
         wl_event_source_remove(surface->frame_done_timer);
@@ -20,12 +29,85 @@ static void handle_destroy(struct wl_listener *listener, void *data) {
     free(surface);
 }
 
+static void handle_commit(struct wl_listener *listener, void *data) {
+    struct sway_surface *surface = wl_container_of(listener, surface, commit);
+    struct wl_client *client =
+        wl_resource_get_client(surface->wlr_surface->resource);
+    wls_metrics_note_commit(client);
+
+    if (!surface->frame_done_nsec) {
+        return;
+    }
+    uint64_t now = wls_trace_now();
+    uint64_t usec = (now - surface->frame_done_nsec) / 1000;
+    surface->frame_done_nsec = 0;
+    if (usec > MAX_COMMIT_SAMPLE_USEC) {
+        return;
+    }
+    surface->commit_samples_usec[surface->commit_samples_next] = usec;
+    surface->commit_samples_next =
+        (surface->commit_samples_next + 1) % SURFACE_COMMIT_SAMPLES;
+    if (surface->commit_samples_length < SURFACE_COMMIT_SAMPLES) {
+        surface->commit_samples_length++;
+    }
+
+    if (surface->frame_deadline_nsec) {
+        wls_metrics_note_frame_slot(client,
+            now > surface->frame_deadline_nsec);
+        surface->frame_deadline_nsec = 0;
+    }
+}
+
+void surface_note_rendered(struct wlr_surface *wlr_surface) {
+    struct sway_surface *surface = wlr_surface->data;
+    if (surface) {
+        surface->rendered_nsec = wls_trace_now();
+    }
+}
+
+static void send_frame_done(struct sway_surface *surface,
+        const struct timespec *when) {
+    surface->frame_done_sent_nsec = wls_trace_now();
+    // Only time clients that actually asked for a frame callback
+    if (wl_list_empty(&surface->wlr_surface->current.frame_callback_list)) {
+        surface->frame_deadline_nsec = 0;
+    } else {
+        surface->frame_done_nsec = surface->frame_done_sent_nsec;
+    }
+    wlr_surface_send_frame_done(surface->wlr_surface, when);
+}
+
+void surface_send_frame_done(struct sway_surface *surface,
+        const struct timespec *when) {
+    surface->frame_deadline_nsec = 0;
+    send_frame_done(surface, when);
+}
+
+void surface_schedule_frame_done(struct sway_surface *surface, int delay,
+        uint64_t deadline_nsec) {
+    surface->frame_deadline_nsec = deadline_nsec;
+    wl_event_source_timer_update(surface->frame_done_timer, delay);
+}
+
+int surface_get_commit_time(struct sway_surface *surface) {
+    if (surface->commit_samples_length < MIN_COMMIT_SAMPLES) {
+        return -1;
+    }
+    uint32_t slowest = 0;
+    for (int i = 0; i < surface->commit_samples_length; ++i) {
+        if (surface->commit_samples_usec[i] > slowest) {
+            slowest = surface->commit_samples_usec[i];
+        }
+    }
+    return (slowest + COMMIT_MARGIN_USEC + 999) / 1000;
+}
+
 static int surface_frame_done_timer_handler(void *data) {
     struct sway_surface *surface = data;
 
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
-    wlr_surface_send_frame_done(surface->wlr_surface, &now);
+    send_frame_done(surface, &now);
 
     return 0;
 }
@@ -40,6 +122,9 @@ void handle_compositor_new_surface(struct wl_listener *listener, void *data) {
     surface->destroy.notify = handle_destroy;
     wl_signal_add(&wlr_surface->events.destroy, &surface->destroy);
 
+    surface->commit.notify = handle_commit;
+    wl_signal_add(&wlr_surface->events.commit, &surface->commit);
+
     surface->frame_done_timer = wl_event_loop_add_timer(wls->server->wl_event_loop,
         surface_frame_done_timer_handler, surface);
     if (!surface->frame_done_timer) {
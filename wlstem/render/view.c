@@ -1,5 +1,6 @@
 #define _POSIX_C_SOURCE 200809L
 #include "config.h"
+#include <wlr/render/wlr_texture.h>
 #include <wlr/types/wlr_surface.h>
 #include <wlr/types/wlr_xdg_shell.h>
 #if HAVE_XWAYLAND
@@ -9,6 +10,7 @@
 #include "log.h"
 #include "view.h"
 #include "window.h"
+#include "wlstem.h"
 
 void view_destroy(struct sway_view *view) {
     if (!sway_assert(view->surface == NULL, "Tried to free mapped view")) {
@@ -50,6 +52,11 @@ static void view_save_buffer_iterator(struct wlr_surface *surface,
         saved_buffer->y = sy;
         saved_buffer->transform = surface->current.transform;
         wlr_surface_get_buffer_source_box(surface, &saved_buffer->source_box);
+        struct wlr_texture *texture = surface->buffer->texture;
+        if (texture) {
+            saved_buffer->bytes = (size_t)texture->width * texture->height * 4;
+            wls->metrics.saved_buffer_bytes += saved_buffer->bytes;
+        }
         wl_list_insert(&view->saved_buffers, &saved_buffer->link);
     }
 }
@@ -68,6 +75,7 @@ void view_remove_saved_buffer(struct sway_view *view) {
     struct sway_saved_buffer *saved_buf, *tmp;
     wl_list_for_each_safe(saved_buf, tmp, &view->saved_buffers, link) {
         wlr_buffer_unlock(&saved_buf->buffer->base);
+        wls->metrics.saved_buffer_bytes -= saved_buf->bytes;
         wl_list_remove(&saved_buf->link);
         free(saved_buf);
     }
@@ -0,0 +1,157 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "list.h"
+#include "vec.h"
+
+/**
+ * Compares the typed vectors of vec.h with list_t on the access patterns of
+ * the structures that were ported to them:
+ * - dirty nodes, pushed by node_set_dirty() and cleared once per transaction
+ * - the outputs a window is on, updated by untrack_output()
+ * - the enabled outputs, found and removed by output_disable()
+ */
+
+struct item {
+    int index; // for the indexed vector
+};
+
+WLS_VEC_DEFINE(item_vec, struct item *)
+WLS_VEC_DEFINE_INDEXED(item_index, struct item *, index)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void report(const char *name, int n, uint64_t list_ns,
+        uint64_t vec_ns) {
+    printf("%-32s n=%-6d list_t %8.1f ns/op  vec %8.1f ns/op  (x%.1f)\n",
+        name, n, (double)list_ns / n, (double)vec_ns / n,
+        (double)list_ns / vec_ns);
+}
+
+static void shuffle(struct item **items, int n) {
+    for (int i = n - 1; i > 0; --i) {
+        int j = rand() % (i + 1);
+        struct item *tmp = items[i];
+        items[i] = items[j];
+        items[j] = tmp;
+    }
+}
+
+// A transaction of n dirty nodes, 100 times over
+static void bench_dirty_nodes(struct item *items, int n) {
+    const int rounds = 100;
+    list_t *list = create_list();
+    uint64_t start = now_ns();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < n; ++i) {
+            list_add(list, &items[i]);
+        }
+        list->length = 0;
+    }
+    uint64_t list_ns = now_ns() - start;
+    list_free(list);
+
+    struct item_vec vec = {0};
+    start = now_ns();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < n; ++i) {
+            item_vec_push(&vec, &items[i]);
+        }
+        item_vec_clear(&vec);
+    }
+    uint64_t vec_ns = now_ns() - start;
+    item_vec_finish(&vec);
+    report("dirty nodes: push + clear", n * rounds, list_ns, vec_ns);
+}
+
+// n windows on two outputs each, untracking one of the outputs
+static void bench_untrack_output(struct item *outputs, int n) {
+    list_t **lists = malloc(sizeof(list_t *) * n);
+    struct item_vec *vecs = calloc(n, sizeof(struct item_vec));
+    for (int i = 0; i < n; ++i) {
+        lists[i] = create_list();
+        list_add(lists[i], &outputs[0]);
+        list_add(lists[i], &outputs[1]);
+        item_vec_push(&vecs[i], &outputs[0]);
+        item_vec_push(&vecs[i], &outputs[1]);
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < n; ++i) {
+        int index = list_find(lists[i], &outputs[0]);
+        if (index >= 0) {
+            list_del(lists[i], index);
+        }
+    }
+    uint64_t list_ns = now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < n; ++i) {
+        int index = item_vec_find(&vecs[i], &outputs[0]);
+        if (index >= 0) {
+            item_vec_remove(&vecs[i], index);
+        }
+    }
+    uint64_t vec_ns = now_ns() - start;
+
+    for (int i = 0; i < n; ++i) {
+        list_free(lists[i]);
+        item_vec_finish(&vecs[i]);
+    }
+    free(lists);
+    free(vecs);
+    report("window outputs: find + remove", n, list_ns, vec_ns);
+}
+
+// n items, all found and removed in random order
+static void bench_find_remove(struct item *items, int n) {
+    struct item **order = malloc(sizeof(struct item *) * n);
+    for (int i = 0; i < n; ++i) {
+        order[i] = &items[i];
+    }
+    shuffle(order, n);
+
+    list_t *list = create_list();
+    struct item_index index = {0};
+    for (int i = 0; i < n; ++i) {
+        list_add(list, &items[i]);
+        item_index_push(&index, &items[i]);
+    }
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < n; ++i) {
+        list_del(list, list_find(list, order[i]));
+    }
+    uint64_t list_ns = now_ns() - start;
+
+    start = now_ns();
+    for (int i = 0; i < n; ++i) {
+        item_index_swap_remove(&index, item_index_find(&index, order[i]));
+    }
+    uint64_t vec_ns = now_ns() - start;
+
+    list_free(list);
+    item_index_finish(&index);
+    free(order);
+    report("indexed: find + swap remove", n, list_ns, vec_ns);
+}
+
+int main(void) {
+    srand(1);
+    const int sizes[] = { 10, 1000, 10000 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        int n = sizes[s];
+        struct item *items = calloc(n, sizeof(struct item));
+        bench_dirty_nodes(items, n);
+        bench_untrack_output(items, n);
+        bench_find_remove(items, n);
+        free(items);
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "list.h"
+
+struct entry {
+    int key;
+    int seq; // insertion order, to check stability
+};
+
+static int compare_key(const void *a, const void *b) {
+    const struct entry *ea = *(struct entry *const *)a;
+    const struct entry *eb = *(struct entry *const *)b;
+    return (ea->key > eb->key) - (ea->key < eb->key);
+}
+
+/**
+ * Sort n entries with keys in [0, keys) and check that they end up ordered by
+ * key, with equal keys still in insertion order.
+ */
+static bool check_stable_sort(int n, int keys) {
+    struct entry *entries = calloc(n, sizeof(struct entry));
+    list_t *list = create_list();
+    for (int i = 0; i < n; ++i) {
+        entries[i].key = rand() % keys;
+        entries[i].seq = i;
+        list_add(list, &entries[i]);
+    }
+
+    list_stable_sort(list, compare_key);
+
+    bool ok = list->length == n;
+    for (int i = 1; ok && i < list->length; ++i) {
+        struct entry *prev = list->items[i - 1];
+        struct entry *cur = list->items[i];
+        if (prev->key > cur->key ||
+                (prev->key == cur->key && prev->seq > cur->seq)) {
+            fprintf(stderr, "n=%d keys=%d: items %d and %d out of order\n",
+                n, keys, i - 1, i);
+            ok = false;
+        }
+    }
+
+    list_free(list);
+    free(entries);
+    return ok;
+}
+
+int main(void) {
+    srand(1);
+    // Around and above the insertion sort cutoff, with many duplicates
+    const int sizes[] = { 0, 1, 2, 15, 16, 17, 33, 100, 1000, 10000 };
+    const int keys[] = { 1, 3, 100 };
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        for (size_t j = 0; j < sizeof(keys) / sizeof(keys[0]); ++j) {
+            ok &= check_stable_sort(sizes[i], keys[j]);
+        }
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_TRANSACTION
 #include <stdlib.h>
 #include "output.h"
 #include "node.h"
@@ -16,7 +17,6 @@ struct wls_node_manager * node_manager_create(void) {
         return NULL;
     }
     node_manager->transactions = create_list();
-    node_manager->dirty_nodes = create_list();
 
     wl_signal_init(&node_manager->events.new_node);
     return node_manager;
@@ -27,7 +27,7 @@ void node_manager_destroy(struct wls_node_manager *node_manager) {
         return;
     }
     list_free(node_manager->transactions);
-    list_free(node_manager->dirty_nodes);
+    wls_node_vec_finish(&node_manager->dirty_nodes);
     free(node_manager);
 }
 
@@ -47,7 +47,7 @@ void node_set_dirty(struct wls_transaction_node *node) {
         return;
     }
     node->dirty = true;
-    list_add(wls->node_manager->dirty_nodes, node);
+    wls_node_vec_push(&wls->node_manager->dirty_nodes, node);
 }
 
 bool node_is_view(struct wls_transaction_node *node) {
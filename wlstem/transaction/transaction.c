@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#define SWAY_LOG_CATEGORY SWAY_LOG_TRANSACTION
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,15 +16,20 @@
 #include "view.h"
 #include "list.h"
 #include "log.h"
+#include "profile.h"
+#include "trace.h"
+#include "vec.h"
 #include "window.h"
 #include "wlstem.h"
 #include "server.h"
 
 #define DEFAULT_TRANSACTION_TIMEOUT_MS 200
 
+WLS_VEC_DEFINE(instruction_vec, struct sway_transaction_instruction *)
+
 struct sway_transaction {
     struct wl_event_source *timer;
-    list_t *instructions;   // struct sway_transaction_instruction *
+    struct instruction_vec instructions;
     size_t num_waiting;
     size_t num_configures;
     struct timespec commit_time;
@@ -45,15 +51,14 @@ static struct sway_transaction *transaction_create(void) {
     if (!sway_assert(transaction, "Unable to allocate transaction")) {
         return NULL;
     }
-    transaction->instructions = create_list();
     return transaction;
 }
 
 static void transaction_destroy(struct sway_transaction *transaction) {
     // Free instructions
-    for (int i = 0; i < transaction->instructions->length; ++i) {
+    for (int i = 0; i < transaction->instructions.length; ++i) {
         struct sway_transaction_instruction *instruction =
-            transaction->instructions->items[i];
+            transaction->instructions.items[i];
         struct wls_transaction_node *node = instruction->node;
         node->ntxnrefs--;
         if (node->instruction == instruction) {
@@ -71,7 +76,7 @@ static void transaction_destroy(struct sway_transaction *transaction) {
         }
         free(instruction);
     }
-    list_free(transaction->instructions);
+    instruction_vec_finish(&transaction->instructions);
 
     if (transaction->timer) {
         wl_event_source_remove(transaction->timer);
@@ -88,10 +93,8 @@ static void copy_output_state(struct sway_output *output,
     state->active = output->active;
 }
 
-static void copy_window_state(struct wls_window *window,
-        struct sway_transaction_instruction *instruction) {
-    struct wls_window_state *state = &instruction->window_state;
-
+static void get_window_state(struct wls_window *window,
+        struct wls_window_state *state) {
     state->x = window->x;
     state->y = window->y;
     state->width = window->width;
@@ -111,6 +114,64 @@ static void copy_window_state(struct wls_window *window,
     state->focused = false; //XXX
 }
 
+static void copy_window_state(struct wls_window *window,
+        struct sway_transaction_instruction *instruction) {
+    get_window_state(window, &instruction->window_state);
+}
+
+static bool window_state_equal(const struct wls_window_state *a,
+        const struct wls_window_state *b) {
+    return a->x == b->x && a->y == b->y &&
+        a->width == b->width && a->height == b->height &&
+        a->output == b->output && a->focused == b->focused &&
+        a->content_x == b->content_x && a->content_y == b->content_y &&
+        a->content_width == b->content_width &&
+        a->content_height == b->content_height;
+}
+
+static bool output_state_equal(struct sway_output *output,
+        const struct sway_output_state *state) {
+    if (output->active != state->active) {
+        return false;
+    }
+    if (!output->windows || !state->windows) {
+        return output->windows == state->windows;
+    }
+    return output->windows->length == state->windows->length &&
+        memcmp(output->windows->items, state->windows->items,
+            sizeof(void *) * output->windows->length) == 0;
+}
+
+/**
+ * Return whether the pending state of the node is the one it already has, or
+ * will have once the transaction it is part of is applied. Such nodes would
+ * only be configured, have their buffers saved and be damaged for nothing.
+ */
+static bool node_is_unchanged(struct wls_transaction_node *node) {
+    if (node->destroying) {
+        return false;
+    }
+    // Without knowing which state queued transactions hold, compare only
+    // against current or the single in-flight instruction
+    if (node->ntxnrefs > 1 || (node->ntxnrefs == 1 && !node->instruction)) {
+        return false;
+    }
+    struct sway_transaction_instruction *instruction = node->instruction;
+    switch (node->type) {
+    case N_OUTPUT:;
+        struct sway_output *output = node->sway_output;
+        return output_state_equal(output,
+            instruction ? &instruction->output_state : &output->current);
+    case N_WINDOW:;
+        struct wls_window *window = node->wls_window;
+        struct wls_window_state pending;
+        get_window_state(window, &pending);
+        return window_state_equal(&pending,
+            instruction ? &instruction->window_state : &window->current);
+    }
+    return false;
+}
+
 static void transaction_add_node(struct sway_transaction *transaction,
         struct wls_transaction_node *node) {
     struct sway_transaction_instruction *instruction =
@@ -130,7 +191,7 @@ static void transaction_add_node(struct sway_transaction *transaction,
         break;
     }
 
-    list_add(transaction->instructions, instruction);
+    instruction_vec_push(&transaction->instructions, instruction);
     node->ntxnrefs++;
 }
 
@@ -204,27 +265,76 @@ static void apply_window_state(struct wls_window *window,
     }
 }
 
+static void add_output_rebase_region(struct sway_output *output,
+        pixman_region32_t *region) {
+    pixman_region32_union_rect(region, region,
+        output->lx, output->ly, output->width, output->height);
+}
+
+static void add_window_rebase_region(struct wls_window *window,
+        pixman_region32_t *region) {
+    // Pad the box by 1px, because the width is a double and might be a fraction
+    pixman_region32_union_rect(region, region,
+        window->current.x - 1, window->current.y - 1,
+        window->current.width + 2, window->current.height + 2);
+
+    struct sway_view *view = window->view;
+    if (view && view->surface) {
+        pixman_region32_union_rect(region, region,
+            window->current.content_x - view->geometry.x,
+            window->current.content_y - view->geometry.y,
+            view->surface->current.width,
+            view->surface->current.height);
+    }
+}
+
+/**
+ * Add the area covered by the node's current state to `region`, so that
+ * cursors in that area can be rebased once the transaction is applied.
+ */
+static void add_node_rebase_region(struct wls_transaction_node *node,
+        pixman_region32_t *region) {
+    switch (node->type) {
+    case N_OUTPUT:
+        add_output_rebase_region(node->sway_output, region);
+        break;
+    case N_WINDOW:
+        add_window_rebase_region(node->wls_window, region);
+        break;
+    }
+}
+
 /**
  * Apply a transaction to the "current" state of the tree.
  */
 static void transaction_apply(struct sway_transaction *transaction) {
+    WLS_TRACE_SCOPE("transaction_apply");
     sway_log(SWAY_DEBUG, "Applying transaction %p", transaction);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    struct timespec *commit = &transaction->commit_time;
+    int64_t waited_usec = (int64_t)(now.tv_sec - commit->tv_sec) * 1000000 +
+        (now.tv_nsec - commit->tv_nsec) / 1000;
+    wls_latency_histogram_add(&wls->metrics.transaction_time, waited_usec);
     if (wls->debug.txn_timings) {
-        struct timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        struct timespec *commit = &transaction->commit_time;
-        float ms = (now.tv_sec - commit->tv_sec) * 1000 +
-            (now.tv_nsec - commit->tv_nsec) / 1000000.0;
+        float ms = waited_usec / 1000.0f;
         sway_log(SWAY_DEBUG, "Transaction %p: %.1fms waiting "
                 "(%.1f frames if 60Hz)", transaction, ms, ms / (1000.0f / 60));
     }
 
+    // Only the cursors over the old or new location of the affected nodes
+    // need to be rebased afterwards
+    pixman_region32_t rebase_region;
+    pixman_region32_init(&rebase_region);
+
     // Apply the instruction state to the node's current state
-    for (int i = 0; i < transaction->instructions->length; ++i) {
+    for (int i = 0; i < transaction->instructions.length; ++i) {
         struct sway_transaction_instruction *instruction =
-            transaction->instructions->items[i];
+            transaction->instructions.items[i];
         struct wls_transaction_node *node = instruction->node;
 
+        add_node_rebase_region(node, &rebase_region);
+
         switch (node->type) {
         case N_OUTPUT:
             apply_output_state(node->sway_output, &instruction->output_state);
@@ -235,10 +345,14 @@ static void transaction_apply(struct sway_transaction *transaction) {
             break;
         }
 
+        add_node_rebase_region(node, &rebase_region);
         node->instruction = NULL;
     }
 
-    cursor_rebase_all();
+    cursor_rebase_region(&rebase_region);
+    pixman_region32_fini(&rebase_region);
+
+    cursor_invalidate_all_touch_points();
 }
 
 static void transaction_commit(struct sway_transaction *transaction);
@@ -246,12 +360,12 @@ static void transaction_commit(struct sway_transaction *transaction);
 // Return true if both transactions operate on the same nodes
 static bool transaction_same_nodes(struct sway_transaction *a,
         struct sway_transaction *b) {
-    if (a->instructions->length != b->instructions->length) {
+    if (a->instructions.length != b->instructions.length) {
         return false;
     }
-    for (int i = 0; i < a->instructions->length; ++i) {
-        struct sway_transaction_instruction *a_inst = a->instructions->items[i];
-        struct sway_transaction_instruction *b_inst = b->instructions->items[i];
+    for (int i = 0; i < a->instructions.length; ++i) {
+        struct sway_transaction_instruction *a_inst = a->instructions.items[i];
+        struct sway_transaction_instruction *b_inst = b->instructions.items[i];
         if (a_inst->node != b_inst->node) {
             return false;
         }
@@ -308,9 +422,11 @@ static void transaction_progress_queue(void) {
 }
 
 static int handle_timeout(void *data) {
+    WLS_PROFILE_CALLBACK_NAMED("transaction_handle_timeout");
     struct sway_transaction *transaction = data;
     sway_log(SWAY_DEBUG, "Transaction %p timed out (%zi waiting)",
             transaction, transaction->num_waiting);
+    wls->metrics.transaction_timeouts++;
     transaction->num_waiting = 0;
     transaction_progress_queue();
     return 0;
@@ -348,12 +464,13 @@ static bool should_configure(struct wls_transaction_node *node,
 }
 
 static void transaction_commit(struct sway_transaction *transaction) {
+    WLS_TRACE_SCOPE("transaction_commit");
     sway_log(SWAY_DEBUG, "Transaction %p committing with %i instructions",
-            transaction, transaction->instructions->length);
+            transaction, transaction->instructions.length);
     transaction->num_waiting = 0;
-    for (int i = 0; i < transaction->instructions->length; ++i) {
+    for (int i = 0; i < transaction->instructions.length; ++i) {
         struct sway_transaction_instruction *instruction =
-            transaction->instructions->items[i];
+            transaction->instructions.items[i];
         struct wls_transaction_node *node = instruction->node;
         if (should_configure(node, instruction)) {
             instruction->serial = view_configure(node->wls_window->view,
@@ -381,9 +498,8 @@ static void transaction_commit(struct sway_transaction *transaction) {
         node->instruction = instruction;
     }
     transaction->num_configures = transaction->num_waiting;
-    if (wls->debug.txn_timings) {
-        clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
-    }
+    clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
+    wls->metrics.transactions_committed++;
     if (wls->debug.noatomic) {
         transaction->num_waiting = 0;
     } else if (wls->debug.txn_wait) {
@@ -469,20 +585,29 @@ void transaction_notify_view_ready_immediately(struct sway_view *view) {
 }
 
 void transaction_commit_dirty(void) {
-    list_t *dirty_nodes = wls->node_manager->dirty_nodes;
-    if (!dirty_nodes) {
-        return;
-    }
+    struct wls_node_vec *dirty_nodes = &wls->node_manager->dirty_nodes;
     struct sway_transaction *transaction = transaction_create();
     if (!transaction) {
         return;
     }
+    instruction_vec_reserve(&transaction->instructions, dirty_nodes->length);
     for (int i = 0; i < dirty_nodes->length; ++i) {
         struct wls_transaction_node *node = dirty_nodes->items[i];
-        transaction_add_node(transaction, node);
         node->dirty = false;
+        if (node_is_unchanged(node)) {
+            wls->metrics.transaction_nodes_skipped++;
+            continue;
+        }
+        transaction_add_node(transaction, node);
+        wls->metrics.transaction_nodes++;
+    }
+    wls_node_vec_clear(dirty_nodes);
+
+    // Nothing changed, don't queue an empty transaction behind the others
+    if (transaction->instructions.length == 0) {
+        transaction_destroy(transaction);
+        return;
     }
-    dirty_nodes->length = 0;
 
     list_add(wls->node_manager->transactions, transaction);
 
@@ -1,61 +1,201 @@
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <unistd.h>
-#include <signal.h>
+#include <wayland-server-core.h>
+#include "exec.h"
 #include "log.h"
+#include "server.h"
+#include "wlstem.h"
 
-bool wls_try_exec(char *cmd) {
-    if (cmd == NULL) {
+extern char **environ;
+
+struct wls_child {
+    pid_t pid;
+    wls_child_exit_func_t on_exit;
+    void *data;
+    struct wl_event_source *pidfd_source; // NULL if tracked via SIGCHLD
+    struct wl_list link; // children
+};
+
+static struct wl_list children = { &children, &children };
+static struct wl_event_source *sigchld_source = NULL;
+static bool pidfd_unsupported = false;
+
+static void child_destroy(struct wls_child *child) {
+    if (child->pidfd_source) {
+        int fd = wl_event_source_get_fd(child->pidfd_source);
+        wl_event_source_remove(child->pidfd_source);
+        close(fd);
+    }
+    wl_list_remove(&child->link);
+    free(child);
+}
+
+/**
+ * Reap the child if it exited. Returns true if it did, in which case the
+ * child has been destroyed.
+ */
+static bool child_try_reap(struct wls_child *child) {
+    int status;
+    pid_t ret = waitpid(child->pid, &status, WNOHANG);
+    if (ret == 0 || (ret < 0 && errno == EINTR)) {
         return false;
     }
+    if (ret < 0) {
+        sway_log_errno(SWAY_ERROR, "waitpid(%d) failed", child->pid);
+        status = 0;
+    } else {
+        sway_log(SWAY_DEBUG, "Child process %d exited", child->pid);
+    }
+    if (child->on_exit) {
+        child->on_exit(child->pid, status, child->data);
+    }
+    child_destroy(child);
+    return true;
+}
+
+static int handle_pidfd(int fd, uint32_t mask, void *data) {
+    child_try_reap(data);
+    return 0;
+}
 
-    int fd[2];
-    if (pipe(fd) != 0) {
-        sway_log(SWAY_ERROR, "Unable to create pipe for fork");
-    }
-
-    pid_t pid, child;
-    // Fork process
-    if ((pid = fork()) == 0) {
-        // Fork child process again
-        setsid();
-        sigset_t set;
-        sigemptyset(&set);
-        sigprocmask(SIG_SETMASK, &set, NULL);
-        close(fd[0]);
-        if ((child = fork()) == 0) {
-            close(fd[1]);
-            execl("/bin/sh", "/bin/sh", "-c", cmd, (void *)NULL);
-            _exit(0);
+static int handle_sigchld(int signal, void *data) {
+    struct wls_child *child, *tmp;
+    wl_list_for_each_safe(child, tmp, &children, link) {
+        if (!child->pidfd_source) {
+            child_try_reap(child);
         }
-        ssize_t s = 0;
-        while ((size_t)s < sizeof(pid_t)) {
-            s += write(fd[1], ((uint8_t *)&child) + s, sizeof(pid_t) - s);
+    }
+    return 0;
+}
+
+static int pidfd_open(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/**
+ * Children without a pidfd are reaped on SIGCHLD. This blocks SIGCHLD in the
+ * main thread, every other thread blocks all signals.
+ */
+static bool sigchld_source_init(void) {
+    if (!sigchld_source) {
+        sigchld_source = wl_event_loop_add_signal(wls->server->wl_event_loop,
+            SIGCHLD, handle_sigchld, NULL);
+    }
+    return sigchld_source != NULL;
+}
+
+static bool child_track_pidfd(struct wls_child *child) {
+    int fd = pidfd_open(child->pid);
+    if (fd < 0) {
+        // Kernels older than 5.3 don't have pidfds
+        if (errno == ENOSYS) {
+            pidfd_unsupported = true;
         }
-        close(fd[1]);
-        _exit(0); // Close child process
-    } else if (pid < 0) {
-        close(fd[0]);
-        close(fd[1]);
-        sway_log(SWAY_ERROR, "First fork() failed");
         return false;
     }
-    close(fd[1]); // close write
-    ssize_t s = 0;
-    while ((size_t)s < sizeof(pid_t)) {
-        s += read(fd[0], ((uint8_t *)&child) + s, sizeof(pid_t) - s);
-    }
-    close(fd[0]);
-    // cleanup child process
-    waitpid(pid, NULL, 0);
-    if (child > 0) {
-        sway_log(SWAY_DEBUG, "Child process created with pid %d", child);
-    } else {
-        sway_log(SWAY_ERROR, "Second fork() failed!");
+    child->pidfd_source = wl_event_loop_add_fd(wls->server->wl_event_loop, fd,
+        WL_EVENT_READABLE, handle_pidfd, child);
+    if (!child->pidfd_source) {
+        close(fd);
         return false;
     }
     return true;
 }
+
+/**
+ * Watch the child through a pidfd, or else through SIGCHLD. Returns false if
+ * neither is possible; the child then stays listed, to be reaped by a later
+ * SIGCHLD.
+ */
+static bool child_track(struct wls_child *child) {
+    if (!pidfd_unsupported && child_track_pidfd(child)) {
+        return true;
+    }
+    if (!sigchld_source) {
+        if (!sigchld_source_init()) {
+            return false;
+        }
+        // The child may have exited before SIGCHLD was blocked, in which
+        // case its signal is gone
+        child_try_reap(child);
+    }
+    return true;
+}
+
+pid_t wls_spawn(const char *cmd, wls_child_exit_func_t on_exit, void *data) {
+    if (cmd == NULL) {
+        return -1;
+    }
+
+    struct wls_child *child = calloc(1, sizeof(struct wls_child));
+    if (!sway_assert(child, "Failed to allocate child")) {
+        return -1;
+    }
+    child->on_exit = on_exit;
+    child->data = data;
+
+    // Without pidfds, watch SIGCHLD before spawning, so that it can't be
+    // missed
+    if (pidfd_unsupported && !sigchld_source_init()) {
+        sway_log(SWAY_ERROR, "Unable to watch SIGCHLD");
+    }
+
+    // posix_spawn() uses vfork semantics, so unlike fork() it doesn't copy
+    // our page tables, and returns as soon as the child has exec'd
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t set;
+    sigemptyset(&set);
+    posix_spawnattr_setsigmask(&attr, &set);
+    sigaddset(&set, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &set);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID |
+        POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    char *const argv[] = { "/bin/sh", "-c", (char *)cmd, NULL };
+    int ret = posix_spawn(&child->pid, "/bin/sh", NULL, &attr, argv, environ);
+    posix_spawnattr_destroy(&attr);
+    if (ret != 0) {
+        sway_log(SWAY_ERROR, "Unable to spawn '%s': %s", cmd, strerror(ret));
+        free(child);
+        return -1;
+    }
+    pid_t pid = child->pid;
+    sway_log(SWAY_DEBUG, "Child process created with pid %d", pid);
+
+    // Children stay listed until reaped, even when they can't be watched
+    // yet, so that the next SIGCHLD reaps them
+    wl_list_insert(&children, &child->link);
+    if (!child_track(child)) {
+        sway_log(SWAY_ERROR, "Unable to track child process %d", pid);
+    }
+    return pid;
+}
+
+void wls_spawn_fini(void) {
+    struct wls_child *child, *tmp;
+    wl_list_for_each_safe(child, tmp, &children, link) {
+        child_destroy(child);
+    }
+    if (sigchld_source) {
+        wl_event_source_remove(sigchld_source);
+        sigchld_source = NULL;
+    }
+}
+
+bool wls_try_exec(char *cmd) {
+    return wls_spawn(cmd, NULL, NULL) > 0;
+}
@@ -90,8 +90,8 @@ static bool get_surface_box(struct surface_iterator_data *data,
 
 void wls_output_layout_for_each_window(void (*f)(struct wls_window *win, void *data),
         void *data) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         output_for_each_window(output, f, data);
     }
 
@@ -102,8 +102,8 @@ void wls_output_layout_for_each_window(void (*f)(struct wls_window *win, void *d
 
 void wls_output_layout_for_each_output(void (*f)(struct sway_output *output, void *data),
         void *data) {
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         f(output, data);
     }
 }
@@ -96,55 +96,69 @@ void list_move_to_end(list_t *list, void *item) {
     list_add(list, item);
 }
 
-static void list_rotate(list_t *list, int from, int to) {
-    void *tmp = list->items[to];
-
-    while (to > from) {
-        list->items[to] = list->items[to - 1];
-        to--;
+// Ranges at most this long are insertion sorted instead of being split
+#define LIST_SORT_INSERTION_CUTOFF 16
+
+static void list_insertion_sort(void **items, int first, int last,
+        int compare(const void *a, const void *b)) {
+    for (int i = first + 1; i < last; ++i) {
+        void *item = items[i];
+        int j = i;
+        while (j > first && compare(&items[j - 1], &item) > 0) {
+            items[j] = items[j - 1];
+            j--;
+        }
+        items[j] = item;
     }
-
-    list->items[from] = tmp;
 }
 
-static void list_inplace_merge(list_t *list, int left, int last, int mid, int compare(const void *a, const void *b)) {
-    int right = mid + 1;
+/**
+ * Merge sort items[first, last), using `buffer` to hold the left half while
+ * merging. Equal items are taken from the left half first, which keeps the
+ * sort stable.
+ */
+static void list_merge_sort(void **items, void **buffer, int first, int last,
+        int compare(const void *a, const void *b)) {
+    if (last - first <= LIST_SORT_INSERTION_CUTOFF) {
+        list_insertion_sort(items, first, last, compare);
+        return;
+    }
 
-    if (compare(&list->items[mid], &list->items[right]) <= 0) {
+    int mid = first + (last - first) / 2;
+    list_merge_sort(items, buffer, first, mid, compare);
+    list_merge_sort(items, buffer, mid, last, compare);
+    if (compare(&items[mid - 1], &items[mid]) <= 0) {
         return;
     }
 
-    while (left <= mid && right <= last) {
-        if (compare(&list->items[left], &list->items[right]) <= 0) {
-            left++;
+    int left_length = mid - first;
+    memcpy(buffer, &items[first], sizeof(void *) * left_length);
+    int left = 0, right = mid, out = first;
+    while (left < left_length && right < last) {
+        if (compare(&items[right], &buffer[left]) < 0) {
+            items[out++] = items[right++];
         } else {
-            list_rotate(list, left, right);
-            left++;
-            mid++;
-            right++;
+            items[out++] = buffer[left++];
         }
     }
+    // Whatever is left of the right half is already in place
+    memcpy(&items[out], &buffer[left], sizeof(void *) * (left_length - left));
 }
 
-static void list_inplace_sort(list_t *list, int first, int last, int compare(const void *a, const void *b)) {
-    if (first >= last) {
+void list_stable_sort(list_t *list, int compare(const void *a, const void *b)) {
+    if (list->length <= LIST_SORT_INSERTION_CUTOFF) {
+        list_insertion_sort(list->items, 0, list->length, compare);
         return;
-    } else if ((last - first) == 1) {
-        if (compare(&list->items[first], &list->items[last]) > 0) {
-            list_swap(list, first, last);
-        }
-    } else {
-        int mid = (int)((last + first) / 2);
-        list_inplace_sort(list, first, mid, compare);
-        list_inplace_sort(list, mid + 1, last, compare);
-        list_inplace_merge(list, first, last, mid, compare);
     }
-}
-
-void list_stable_sort(list_t *list, int compare(const void *a, const void *b)) {
-    if (list->length > 1) {
-        list_inplace_sort(list, 0, list->length - 1, compare);
+    void **buffer = malloc(sizeof(void *) * (list->length / 2 + 1));
+    if (!buffer) {
+        sway_log(SWAY_ERROR, "Unable to allocate sort buffer, "
+            "falling back to insertion sort");
+        list_insertion_sort(list->items, 0, list->length, compare);
+        return;
     }
+    list_merge_sort(list->items, buffer, 0, list->length, compare);
+    free(buffer);
 }
 
 void list_free_items_and_destroy(list_t *list) {
@@ -1,8 +1,14 @@
 #define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <semaphore.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <unistd.h>
 #include "log.h"
@@ -14,6 +20,7 @@ void _sway_abort(const char *format, ...) {
     va_start(args, format);
     _sway_vlog(SWAY_ERROR, format, args);
     va_end(args);
+    sway_log_flush();
     log_terminate(EXIT_FAILURE);
 }
 
@@ -28,6 +35,7 @@ bool _sway_assert(bool condition, const char *format, ...) {
     va_end(args);
 
 #ifndef NDEBUG
+    sway_log_flush();
     raise(SIGABRT);
 #endif
 
@@ -35,7 +43,20 @@ bool _sway_assert(bool condition, const char *format, ...) {
 }
 
 static bool colored = true;
-static sway_log_importance_t log_importance = SWAY_ERROR;
+static bool stderr_is_tty = false;
+// Errors are shown until sway_log_init() is called, e.g. for bad arguments
+sway_log_importance_t _sway_log_importance[SWAY_LOG_CATEGORY_LAST] = {
+    [SWAY_LOG_GENERAL] = SWAY_ERROR,
+    [SWAY_LOG_TRANSACTION] = SWAY_ERROR,
+    [SWAY_LOG_DAMAGE] = SWAY_ERROR,
+    [SWAY_LOG_OUTPUT] = SWAY_ERROR,
+    [SWAY_LOG_INPUT] = SWAY_ERROR,
+    [SWAY_LOG_SEAT] = SWAY_ERROR,
+    [SWAY_LOG_XWAYLAND] = SWAY_ERROR,
+    [SWAY_LOG_LAYER_SHELL] = SWAY_ERROR,
+};
+_Static_assert(SWAY_LOG_CATEGORY_LAST == 8,
+    "Initialize the importance of new log categories");
 static struct timespec start_time = {-1, -1};
 
 static const char *verbosity_colors[] = {
@@ -52,6 +73,53 @@ static const char *verbosity_headers[] = {
     [SWAY_DEBUG] = "[DEBUG]",
 };
 
+static const char *verbosity_names[] = {
+    [SWAY_SILENT] = "silent",
+    [SWAY_ERROR] = "error",
+    [SWAY_INFO] = "info",
+    [SWAY_DEBUG] = "debug",
+};
+
+static const char *category_names[] = {
+    [SWAY_LOG_GENERAL] = "general",
+    [SWAY_LOG_TRANSACTION] = "transaction",
+    [SWAY_LOG_DAMAGE] = "damage",
+    [SWAY_LOG_OUTPUT] = "output",
+    [SWAY_LOG_INPUT] = "input",
+    [SWAY_LOG_SEAT] = "seat",
+    [SWAY_LOG_XWAYLAND] = "xwayland",
+    [SWAY_LOG_LAYER_SHELL] = "layer-shell",
+};
+
+// Number of lines the asynchronous ring can hold, must be a power of two
+#define LOG_RING_SIZE 512
+// Longer lines are truncated when logged asynchronously
+#define LOG_LINE_MAX 512
+
+struct log_entry {
+    struct timespec ts;
+    sway_log_importance_t verbosity;
+    char text[LOG_LINE_MAX];
+};
+
+/**
+ * Single-producer, single-consumer ring of formatted lines.
+ *
+ * Only the thread which started the asynchronous logger pushes to the ring;
+ * other threads log synchronously. The writer thread is the only consumer.
+ */
+static struct {
+    atomic_bool running;
+    pthread_t owner;
+    pthread_t writer;
+    sem_t wake;
+    atomic_bool stop;
+    atomic_size_t head; // next entry to fill, written by the owner
+    atomic_size_t tail; // next entry to write, written by the writer
+    atomic_uint dropped;
+    struct log_entry *entries;
+} ring;
+
 static void timespec_sub(struct timespec *r, const struct timespec *a,
         const struct timespec *b) {
     const long NSEC_PER_SEC = 1000000000;
@@ -68,59 +136,373 @@ static void init_start_time(void) {
         return;
     }
     clock_gettime(CLOCK_MONOTONIC, &start_time);
+    stderr_is_tty = isatty(STDERR_FILENO);
 }
 
-static void sway_log_stderr(sway_log_importance_t verbosity, const char *fmt,
+static void write_line(sway_log_importance_t verbosity,
+        const struct timespec *ts, const char *tag, const char *fmt,
         va_list args) {
-    init_start_time();
+    struct timespec rel;
+    timespec_sub(&rel, ts, &start_time);
 
-    if (verbosity > log_importance) {
-        return;
-    }
-
-    struct timespec ts = {0};
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    timespec_sub(&ts, &ts, &start_time);
+    flockfile(stderr);
 
-    fprintf(stderr, "%02d:%02d:%02d.%03ld ", (int)(ts.tv_sec / 60 / 60),
-        (int)(ts.tv_sec / 60 % 60), (int)(ts.tv_sec % 60),
-        ts.tv_nsec / 1000000);
+    fprintf(stderr, "%02d:%02d:%02d.%03ld ", (int)(rel.tv_sec / 60 / 60),
+        (int)(rel.tv_sec / 60 % 60), (int)(rel.tv_sec % 60),
+        rel.tv_nsec / 1000000);
 
     unsigned c = (verbosity < SWAY_LOG_IMPORTANCE_LAST) ? verbosity :
         SWAY_LOG_IMPORTANCE_LAST - 1;
 
-    if (colored && isatty(STDERR_FILENO)) {
+    if (colored && stderr_is_tty) {
         fprintf(stderr, "%s", verbosity_colors[c]);
     } else {
         fprintf(stderr, "%s ", verbosity_headers[c]);
     }
 
+    if (tag) {
+        fprintf(stderr, "[%s] ", tag);
+    }
     vfprintf(stderr, fmt, args);
 
-    if (colored && isatty(STDERR_FILENO)) {
+    if (colored && stderr_is_tty) {
         fprintf(stderr, "\x1B[0m");
     }
     fprintf(stderr, "\n");
+
+    funlockfile(stderr);
+}
+
+static void write_entry(const struct log_entry *entry, const char *fmt, ...)
+        ATTRIB_PRINTF(2, 3);
+
+static void write_entry(const struct log_entry *entry, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    write_line(entry->verbosity, &entry->ts, NULL, fmt, args);
+    va_end(args);
+}
+
+static void drain_ring(void) {
+    size_t tail = atomic_load_explicit(&ring.tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring.head, memory_order_acquire);
+    for (; tail != head; ++tail) {
+        const struct log_entry *entry =
+            &ring.entries[tail & (LOG_RING_SIZE - 1)];
+        write_entry(entry, "%s", entry->text);
+        atomic_store_explicit(&ring.tail, tail + 1, memory_order_release);
+    }
+
+    unsigned dropped = atomic_exchange(&ring.dropped, 0);
+    if (dropped) {
+        struct log_entry entry = { .verbosity = SWAY_ERROR };
+        clock_gettime(CLOCK_MONOTONIC, &entry.ts);
+        write_entry(&entry, "[log] %u lines dropped, the log ring was full",
+            dropped);
+    }
+    fflush(stderr);
+}
+
+static void *log_writer_thread(void *data) {
+    while (!atomic_load(&ring.stop)) {
+        sem_wait(&ring.wake);
+        drain_ring();
+    }
+    drain_ring();
+    return NULL;
+}
+
+static bool ring_push(sway_log_importance_t verbosity,
+        const struct timespec *ts, const char *tag, const char *fmt,
+        va_list args) {
+    if (!atomic_load_explicit(&ring.running, memory_order_relaxed) ||
+            !pthread_equal(pthread_self(), ring.owner)) {
+        return false;
+    }
+
+    size_t head = atomic_load_explicit(&ring.head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring.tail, memory_order_acquire);
+    if (head - tail >= LOG_RING_SIZE) {
+        // Waiting for room would stall the event loop as long as stderr is
+        // blocked, and writing the line directly would put it ahead of the
+        // ones still in the ring. Drop it, the writer reports how many were.
+        sem_post(&ring.wake);
+        atomic_fetch_add(&ring.dropped, 1);
+        return true;
+    }
+
+    struct log_entry *entry = &ring.entries[head & (LOG_RING_SIZE - 1)];
+    entry->ts = *ts;
+    entry->verbosity = verbosity;
+    int len = 0;
+    if (tag) {
+        len = snprintf(entry->text, sizeof(entry->text), "[%s] ", tag);
+    }
+    vsnprintf(entry->text + len, sizeof(entry->text) - len, fmt, args);
+    atomic_store_explicit(&ring.head, head + 1, memory_order_release);
+    sem_post(&ring.wake);
+    return true;
+}
+
+static void sway_log_stderr(enum sway_log_category category,
+        sway_log_importance_t verbosity, const char *fmt, va_list args) {
+    if (category >= SWAY_LOG_CATEGORY_LAST ||
+            verbosity > _sway_log_importance[category]) {
+        return;
+    }
+    const char *tag = category != SWAY_LOG_GENERAL ?
+        category_names[category] : NULL;
+
+    init_start_time();
+
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    if (ring_push(verbosity, &ts, tag, fmt, args)) {
+        return;
+    }
+    write_line(verbosity, &ts, tag, fmt, args);
+}
+
+void sway_log_flush(void) {
+    if (!atomic_load(&ring.running)) {
+        return;
+    }
+
+    // Give the writer thread some time to catch up
+    sem_post(&ring.wake);
+    for (int i = 0; i < 100; ++i) {
+        if (atomic_load(&ring.tail) == atomic_load(&ring.head)) {
+            return;
+        }
+        struct timespec delay = { .tv_nsec = 1000000 };
+        nanosleep(&delay, NULL);
+    }
+}
+
+static const int fatal_signals[] = { SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV };
+static struct sigaction fatal_signal_actions[
+    sizeof(fatal_signals) / sizeof(fatal_signals[0])];
+
+static void write_str(const char *str) {
+    size_t len = strlen(str);
+    while (len > 0) {
+        ssize_t ret = write(STDERR_FILENO, str, len);
+        if (ret <= 0) {
+            return;
+        }
+        str += ret;
+        len -= ret;
+    }
+}
+
+/**
+ * Write out the lines still in the ring, from a signal handler. Only
+ * async-signal-safe functions may be used, so lines lose their timestamp and
+ * colors. Lines the writer thread is writing at the same time may show up
+ * twice.
+ */
+static void write_ring_unsafe(void) {
+    size_t tail = atomic_load(&ring.tail);
+    size_t head = atomic_load(&ring.head);
+    for (; tail != head; ++tail) {
+        const struct log_entry *entry =
+            &ring.entries[tail & (LOG_RING_SIZE - 1)];
+        unsigned c = (entry->verbosity < SWAY_LOG_IMPORTANCE_LAST) ?
+            entry->verbosity : SWAY_LOG_IMPORTANCE_LAST - 1;
+        write_str(verbosity_headers[c]);
+        write_str(" ");
+        write_str(entry->text);
+        write_str("\n");
+    }
+}
+
+static void handle_fatal_signal(int sig) {
+    if (atomic_load(&ring.running)) {
+        write_ring_unsafe();
+    }
+    // Hand the signal over to whoever handled it before us, usually the
+    // default action
+    for (size_t i = 0; i < sizeof(fatal_signals) / sizeof(fatal_signals[0]);
+            ++i) {
+        if (fatal_signals[i] == sig) {
+            sigaction(sig, &fatal_signal_actions[i], NULL);
+        }
+    }
+    raise(sig);
+}
+
+static void install_fatal_signal_handlers(void) {
+    struct sigaction sa = { .sa_handler = handle_fatal_signal };
+    sigemptyset(&sa.sa_mask);
+    for (size_t i = 0; i < sizeof(fatal_signals) / sizeof(fatal_signals[0]);
+            ++i) {
+        sigaction(fatal_signals[i], &sa, &fatal_signal_actions[i]);
+    }
+}
+
+bool sway_log_start_async(void) {
+    if (atomic_load(&ring.running)) {
+        return true;
+    }
+
+    ring.entries = calloc(LOG_RING_SIZE, sizeof(struct log_entry));
+    if (!ring.entries) {
+        return false;
+    }
+    if (sem_init(&ring.wake, 0, 0) != 0) {
+        free(ring.entries);
+        ring.entries = NULL;
+        return false;
+    }
+
+    ring.owner = pthread_self();
+    atomic_store(&ring.stop, false);
+    atomic_store(&ring.head, 0);
+    atomic_store(&ring.tail, 0);
+
+    // Signals are handled by the event loop, through signalfds which only
+    // read signals blocked in every thread. Start the writer with all of them
+    // blocked, so that it never gets process-directed ones.
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int ret = pthread_create(&ring.writer, NULL, log_writer_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (ret != 0) {
+        sem_destroy(&ring.wake);
+        free(ring.entries);
+        ring.entries = NULL;
+        return false;
+    }
+
+    atomic_store(&ring.running, true);
+    static bool hooks_installed = false;
+    if (!hooks_installed) {
+        // Lines still in the ring are the most useful ones after a crash
+        install_fatal_signal_handlers();
+        atexit(sway_log_stop_async);
+        hooks_installed = true;
+    }
+    return true;
+}
+
+void sway_log_stop_async(void) {
+    if (!atomic_load(&ring.running)) {
+        return;
+    }
+    atomic_store(&ring.running, false);
+    atomic_store(&ring.stop, true);
+    sem_post(&ring.wake);
+    pthread_join(ring.writer, NULL);
+    sem_destroy(&ring.wake);
+    free(ring.entries);
+    ring.entries = NULL;
 }
 
 void sway_log_init(sway_log_importance_t verbosity, terminate_callback_t callback) {
     init_start_time();
 
     if (verbosity < SWAY_LOG_IMPORTANCE_LAST) {
-        log_importance = verbosity;
+        for (size_t i = 0; i < SWAY_LOG_CATEGORY_LAST; ++i) {
+            _sway_log_importance[i] = verbosity;
+        }
     }
     if (callback) {
         log_terminate = callback;
     }
 }
 
+void sway_log_set_category_importance(enum sway_log_category category,
+        sway_log_importance_t verbosity) {
+    if (category < SWAY_LOG_CATEGORY_LAST &&
+            verbosity < SWAY_LOG_IMPORTANCE_LAST) {
+        _sway_log_importance[category] = verbosity;
+    }
+}
+
+sway_log_importance_t sway_log_get_category_importance(
+        enum sway_log_category category) {
+    return category < SWAY_LOG_CATEGORY_LAST ?
+        _sway_log_importance[category] : SWAY_SILENT;
+}
+
+const char *sway_log_category_name(enum sway_log_category category) {
+    return category < SWAY_LOG_CATEGORY_LAST ? category_names[category] : NULL;
+}
+
+static bool parse_category_level(const char *pair, size_t len) {
+    const char *eq = memchr(pair, '=', len);
+    if (!eq) {
+        return false;
+    }
+    size_t name_len = eq - pair;
+    const char *level = eq + 1;
+    size_t level_len = len - name_len - 1;
+
+    sway_log_importance_t verbosity = SWAY_LOG_IMPORTANCE_LAST;
+    for (size_t i = 0; i < SWAY_LOG_IMPORTANCE_LAST; ++i) {
+        if (strlen(verbosity_names[i]) == level_len &&
+                strncasecmp(level, verbosity_names[i], level_len) == 0) {
+            verbosity = i;
+            break;
+        }
+    }
+    if (verbosity == SWAY_LOG_IMPORTANCE_LAST) {
+        return false;
+    }
+
+    if (name_len == 1 && pair[0] == '*') {
+        for (size_t i = 0; i < SWAY_LOG_CATEGORY_LAST; ++i) {
+            _sway_log_importance[i] = verbosity;
+        }
+        return true;
+    }
+    for (size_t i = 0; i < SWAY_LOG_CATEGORY_LAST; ++i) {
+        if (strlen(category_names[i]) == name_len &&
+                strncasecmp(pair, category_names[i], name_len) == 0) {
+            _sway_log_importance[i] = verbosity;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool sway_log_parse_categories(const char *spec) {
+    bool ok = true;
+    while (*spec) {
+        size_t len = strcspn(spec, ",");
+        if (len > 0 && !parse_category_level(spec, len)) {
+            ok = false;
+        }
+        spec += len;
+        if (*spec == ',') {
+            ++spec;
+        }
+    }
+    return ok;
+}
+
+void _sway_vlog_category(enum sway_log_category category,
+        sway_log_importance_t verbosity, const char *fmt, va_list args) {
+    sway_log_stderr(category, verbosity, fmt, args);
+}
+
+void _sway_log_category(enum sway_log_category category,
+        sway_log_importance_t verbosity, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    sway_log_stderr(category, verbosity, fmt, args);
+    va_end(args);
+}
+
 void _sway_vlog(sway_log_importance_t verbosity, const char *fmt, va_list args) {
-    sway_log_stderr(verbosity, fmt, args);
+    sway_log_stderr(SWAY_LOG_GENERAL, verbosity, fmt, args);
 }
 
 void _sway_log(sway_log_importance_t verbosity, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
-    sway_log_stderr(verbosity, fmt, args);
+    sway_log_stderr(SWAY_LOG_GENERAL, verbosity, fmt, args);
     va_end(args);
 }
@@ -0,0 +1,594 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_output.h>
+#include "log.h"
+#include "metrics.h"
+#include "output.h"
+#include "output_manager.h"
+#include "server.h"
+#include "wlstem.h"
+
+// Bytes of a request read before answering it, even if it isn't complete
+#define METRICS_MAX_REQUEST 4096
+
+struct wls_metrics_collector {
+    wls_metrics_collector_func_t func;
+    void *data;
+    struct wl_list link; // wls_metrics::collectors
+};
+
+struct metrics_connection {
+    int fd;
+    struct wl_event_source *source;
+    size_t request_length;
+    int header_end_matched; // characters of "\r\n\r\n" seen so far
+
+    char *response;
+    size_t response_length;
+    size_t written;
+
+    struct wl_list link; // endpoint::connections
+};
+
+static struct {
+    int fd;
+    char *path;
+    struct wl_event_source *source;
+    struct wl_list connections; // metrics_connection::link
+} endpoint = { .fd = -1 };
+
+void wls_metrics_init(struct wls_metrics *metrics) {
+    wl_list_init(&metrics->clients);
+    wl_list_init(&metrics->collectors);
+}
+
+static void client_metrics_destroy(struct wls_client_metrics *client) {
+    wl_list_remove(&client->destroy.link);
+    wl_list_remove(&client->link);
+    free(client);
+}
+
+void wls_metrics_finish(struct wls_metrics *metrics) {
+    struct wls_client_metrics *client, *client_tmp;
+    wl_list_for_each_safe(client, client_tmp, &metrics->clients, link) {
+        client_metrics_destroy(client);
+    }
+    struct wls_metrics_collector *collector, *collector_tmp;
+    wl_list_for_each_safe(collector, collector_tmp,
+            &metrics->collectors, link) {
+        wl_list_remove(&collector->link);
+        free(collector);
+    }
+}
+
+static void handle_client_destroy(struct wl_listener *listener, void *data) {
+    struct wls_client_metrics *client =
+        wl_container_of(listener, client, destroy);
+    client_metrics_destroy(client);
+}
+
+static struct wls_client_metrics *client_metrics_create(
+        struct wl_client *wl_client) {
+    struct wls_client_metrics *client =
+        calloc(1, sizeof(struct wls_client_metrics));
+    if (!client) {
+        sway_log(SWAY_ERROR, "Unable to allocate client metrics");
+        return NULL;
+    }
+    client->client = wl_client;
+    wl_client_get_credentials(wl_client, &client->pid, NULL, NULL);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/comm", client->pid);
+    FILE *f = fopen(path, "r");
+    if (f) {
+        if (fgets(client->comm, sizeof(client->comm), f)) {
+            client->comm[strcspn(client->comm, "\n")] = '\0';
+        }
+        fclose(f);
+    }
+
+    client->destroy.notify = handle_client_destroy;
+    wl_client_add_destroy_listener(wl_client, &client->destroy);
+    wl_list_insert(&wls->metrics.clients, &client->link);
+    return client;
+}
+
+static struct wls_client_metrics *client_metrics_get(
+        struct wl_client *wl_client) {
+    // The destroy listener doubles as the lookup key
+    struct wl_listener *listener =
+        wl_client_get_destroy_listener(wl_client, handle_client_destroy);
+    struct wls_client_metrics *client;
+    return listener ? wl_container_of(listener, client, destroy) :
+        client_metrics_create(wl_client);
+}
+
+void wls_metrics_note_commit(struct wl_client *wl_client) {
+    struct wls_client_metrics *client = client_metrics_get(wl_client);
+    if (client) {
+        client->commits++;
+    }
+}
+
+void wls_metrics_note_frame_slot(struct wl_client *wl_client, bool missed) {
+    struct wls_client_metrics *client = client_metrics_get(wl_client);
+    if (client) {
+        client->frame_slots++;
+        client->frame_slots_missed += missed;
+    }
+}
+
+void wls_metrics_add_collector(wls_metrics_collector_func_t func, void *data) {
+    struct wls_metrics_collector *collector =
+        calloc(1, sizeof(struct wls_metrics_collector));
+    if (!collector) {
+        sway_log(SWAY_ERROR, "Unable to allocate metrics collector");
+        return;
+    }
+    collector->func = func;
+    collector->data = data;
+    wl_list_insert(wls->metrics.collectors.prev, &collector->link);
+}
+
+static void write_header(FILE *f, const char *name, const char *type,
+        const char *help) {
+    fprintf(f, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * Write a label value, escaped as the text format requires.
+ */
+static void write_label_value(FILE *f, const char *value) {
+    for (const char *c = value; *c; ++c) {
+        switch (*c) {
+        case '\\':
+            fputs("\\\\", f);
+            break;
+        case '"':
+            fputs("\\\"", f);
+            break;
+        case '\n':
+            fputs("\\n", f);
+            break;
+        default:
+            fputc(*c, f);
+        }
+    }
+}
+
+/**
+ * Write the samples of a histogram. `labels` are written as is before the
+ * `le` label, and may be empty.
+ */
+static void write_histogram(FILE *f, const char *name, const char *labels,
+        const struct wls_latency_histogram *histogram) {
+    const char *sep = labels[0] ? "," : "";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < WLS_LATENCY_BUCKETS - 1; ++i) {
+        cumulative += histogram->buckets[i];
+        fprintf(f, "%s_bucket{%s%sle=\"%g\"} %" PRIu64 "\n", name, labels, sep,
+            ((uint64_t)WLS_LATENCY_BUCKET_BASE_USEC << i) / 1e6, cumulative);
+    }
+    fprintf(f, "%s_bucket{%s%sle=\"+Inf\"} %" PRIu64 "\n", name, labels, sep,
+        histogram->count);
+    const char *lbrace = labels[0] ? "{" : "";
+    const char *rbrace = labels[0] ? "}" : "";
+    fprintf(f, "%s_sum%s%s%s %g\n", name, lbrace, labels, rbrace,
+        histogram->sum_usec / 1e6);
+    fprintf(f, "%s_count%s%s%s %" PRIu64 "\n", name, lbrace, labels, rbrace,
+        histogram->count);
+}
+
+static void write_output_value(FILE *f, const char *name, const char *type,
+        const char *help, size_t offset) {
+    write_header(f, name, type, help);
+    struct sway_output *output;
+    wl_list_for_each(output, &wls->output_manager->all_outputs, link) {
+        const uint64_t *value =
+            (const uint64_t *)((const char *)&output->metrics + offset);
+        fprintf(f, "%s{output=\"%s\"} %" PRIu64 "\n",
+            name, output->wlr_output->name, *value);
+    }
+}
+
+/**
+ * Write a pair of histograms of each output, the first one of frames without
+ * adaptive sync and the second one of frames with it.
+ */
+static void write_output_sync_histogram(FILE *f, const char *name,
+        const char *help, size_t offset) {
+    static const char *sync_names[] = { "fixed", "adaptive" };
+    char labels[256];
+    write_header(f, name, "histogram", help);
+    struct sway_output *output;
+    wl_list_for_each(output, &wls->output_manager->all_outputs, link) {
+        const struct wls_latency_histogram *histograms =
+            (const struct wls_latency_histogram *)
+            ((const char *)&output->metrics + offset);
+        for (size_t i = 0; i < 2; ++i) {
+            snprintf(labels, sizeof(labels), "output=\"%s\",sync=\"%s\"",
+                output->wlr_output->name, sync_names[i]);
+            write_histogram(f, name, labels, &histograms[i]);
+        }
+    }
+}
+
+static void write_client_counter(FILE *f, const char *name, const char *help,
+        size_t offset) {
+    write_header(f, name, "counter", help);
+    struct wls_client_metrics *client;
+    wl_list_for_each(client, &wls->metrics.clients, link) {
+        const uint64_t *value =
+            (const uint64_t *)((const char *)client + offset);
+        fprintf(f, "%s{pid=\"%d\",comm=\"", name, client->pid);
+        write_label_value(f, client->comm);
+        fprintf(f, "\"} %" PRIu64 "\n", *value);
+    }
+}
+
+void wls_metrics_write_gauge(FILE *f, const char *name, const char *help,
+        double value) {
+    write_header(f, name, "gauge", help);
+    fprintf(f, "%s %g\n", name, value);
+}
+
+void wls_metrics_write(FILE *f) {
+    struct wls_metrics *metrics = &wls->metrics;
+    char labels[256];
+
+    write_output_value(f, "sway_output_frames_rendered_total", "counter",
+        "Frames rendered and committed.",
+        offsetof(struct wls_output_metrics, frames_rendered));
+    write_output_value(f, "sway_output_frames_skipped_total", "counter",
+        "Frame events with nothing to render.",
+        offsetof(struct wls_output_metrics, frames_skipped));
+    write_output_value(f, "sway_output_frames_cursor_only_total", "counter",
+        "Frames where only software cursors moved, redrawn from a cache. "
+        "The others rendered the scene.",
+        offsetof(struct wls_output_metrics, frames_cursor_only));
+    write_output_value(f, "sway_output_frames_missed_total", "counter",
+        "Delayed frames presented after the refresh they were meant for.",
+        offsetof(struct wls_output_metrics, frames_missed));
+    write_output_value(f, "sway_output_damage_pixels_total", "counter",
+        "Damaged pixels over the rendered frames.",
+        offsetof(struct wls_output_metrics, damage_pixels));
+    write_output_value(f, "sway_output_frame_done_throttled_total", "counter",
+        "Frame done events held back from surfaces that weren't drawn.",
+        offsetof(struct wls_output_metrics, frame_done_throttled));
+    write_output_value(f, "sway_output_surfaces_throttled", "gauge",
+        "Surfaces held back at the last frame.",
+        offsetof(struct wls_output_metrics, surfaces_throttled));
+
+    struct sway_output *output;
+    write_header(f, "sway_output_render_seconds", "histogram",
+        "Time spent rendering and committing a frame.");
+    wl_list_for_each(output, &wls->output_manager->all_outputs, link) {
+        snprintf(labels, sizeof(labels), "output=\"%s\"",
+            output->wlr_output->name);
+        write_histogram(f, "sway_output_render_seconds", labels,
+            &output->metrics.render_time);
+    }
+
+    write_output_sync_histogram(f, "sway_output_frame_interval_seconds",
+        "Time between presented frames.",
+        offsetof(struct wls_output_metrics, frame_interval));
+    write_output_sync_histogram(f, "sway_output_damage_to_present_seconds",
+        "Time from the first damage of the scene, usually a client commit, "
+        "to the presentation of the frame showing it.",
+        offsetof(struct wls_output_metrics, damage_to_present));
+
+    write_header(f, "sway_input_latency_seconds", "histogram",
+        "Input latency, from the input event to the frame commit or "
+        "presentation.");
+    wl_list_for_each(output, &wls->output_manager->all_outputs, link) {
+        for (size_t source = 0; source < WLS_LATENCY_SOURCE_COUNT; ++source) {
+            for (size_t stage = 0; stage < WLS_LATENCY_STAGE_COUNT; ++stage) {
+                const struct wls_latency_histogram *histogram =
+                    &output->latency.histograms[source][stage];
+                if (!histogram->count) {
+                    continue;
+                }
+                snprintf(labels, sizeof(labels),
+                    "output=\"%s\",source=\"%s\",stage=\"%s\"",
+                    output->wlr_output->name,
+                    wls_latency_source_name(source),
+                    wls_latency_stage_name(stage));
+                write_histogram(f, "sway_input_latency_seconds", labels,
+                    histogram);
+            }
+        }
+    }
+
+    write_header(f, "sway_input_events_total", "counter",
+        "Input events handled.");
+    for (size_t source = 0; source < WLS_LATENCY_SOURCE_COUNT; ++source) {
+        fprintf(f, "sway_input_events_total{source=\"%s\"} %" PRIu64 "\n",
+            wls_latency_source_name(source), metrics->input_events[source]);
+    }
+
+    write_header(f, "sway_touch_motion_events_total", "counter",
+        "Touch motion events received.");
+    fprintf(f, "sway_touch_motion_events_total %" PRIu64 "\n",
+        metrics->touch_motion_events);
+    write_header(f, "sway_touch_motion_dispatched_total", "counter",
+        "Touch motions sent to clients after batching.");
+    fprintf(f, "sway_touch_motion_dispatched_total %" PRIu64 "\n",
+        metrics->touch_motion_dispatched);
+    write_header(f, "sway_touch_hit_tests_total", "counter",
+        "Hit-tests done for touch motion.");
+    fprintf(f, "sway_touch_hit_tests_total %" PRIu64 "\n",
+        metrics->touch_hit_tests);
+
+    write_header(f, "sway_output_modesets_total", "counter",
+        "Output commits made to apply a configuration.");
+    fprintf(f, "sway_output_modesets_total %" PRIu64 "\n", metrics->modesets);
+    write_header(f, "sway_output_modeset_seconds_total", "counter",
+        "Time spent in output commits made to apply a configuration.");
+    fprintf(f, "sway_output_modeset_seconds_total %g\n",
+        metrics->modeset_usec / 1e6);
+
+    write_header(f, "sway_transactions_total", "counter",
+        "Transactions committed.");
+    fprintf(f, "sway_transactions_total %" PRIu64 "\n",
+        metrics->transactions_committed);
+    write_header(f, "sway_transaction_timeouts_total", "counter",
+        "Transactions applied because clients didn't answer in time.");
+    fprintf(f, "sway_transaction_timeouts_total %" PRIu64 "\n",
+        metrics->transaction_timeouts);
+    write_header(f, "sway_transaction_nodes_total", "counter",
+        "Nodes added to transactions.");
+    fprintf(f, "sway_transaction_nodes_total %" PRIu64 "\n",
+        metrics->transaction_nodes);
+    write_header(f, "sway_transaction_nodes_skipped_total", "counter",
+        "Dirty nodes left out of transactions because nothing changed.");
+    fprintf(f, "sway_transaction_nodes_skipped_total %" PRIu64 "\n",
+        metrics->transaction_nodes_skipped);
+    write_header(f, "sway_transaction_seconds", "histogram",
+        "Time between the commit and the application of transactions.");
+    write_histogram(f, "sway_transaction_seconds", "",
+        &metrics->transaction_time);
+
+    write_client_counter(f, "sway_client_commits_total",
+        "Surface commits per client.",
+        offsetof(struct wls_client_metrics, commits));
+    write_client_counter(f, "sway_client_frame_slots_total",
+        "Commits in response to a frame done delayed for an output repaint.",
+        offsetof(struct wls_client_metrics, frame_slots));
+    write_client_counter(f, "sway_client_frame_slots_missed_total",
+        "Commits that came too late for the repaint they were meant for.",
+        offsetof(struct wls_client_metrics, frame_slots_missed));
+
+    wls_metrics_write_gauge(f, "sway_saved_buffer_bytes",
+        "Client buffers kept locked while transactions are in flight.",
+        metrics->saved_buffer_bytes);
+
+    struct wls_metrics_collector *collector;
+    wl_list_for_each(collector, &metrics->collectors, link) {
+        collector->func(f, collector->data);
+    }
+}
+
+static void connection_destroy(struct metrics_connection *conn) {
+    wl_event_source_remove(conn->source);
+    close(conn->fd);
+    wl_list_remove(&conn->link);
+    free(conn->response);
+    free(conn);
+}
+
+static bool build_response(struct metrics_connection *conn) {
+    char *body = NULL;
+    size_t body_length = 0;
+    FILE *f = open_memstream(&body, &body_length);
+    if (!f) {
+        return false;
+    }
+    wls_metrics_write(f);
+    fclose(f);
+
+    f = open_memstream(&conn->response, &conn->response_length);
+    if (!f) {
+        free(body);
+        return false;
+    }
+    fprintf(f, "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n"
+        "\r\n", body_length);
+    fwrite(body, 1, body_length, f);
+    fclose(f);
+    free(body);
+    return true;
+}
+
+/**
+ * Read what the client sent so far. Returns true once the request is
+ * complete, or as complete as we care about.
+ */
+static bool read_request(struct metrics_connection *conn, bool *error) {
+    static const char header_end[] = "\r\n\r\n";
+    char buf[512];
+    for (;;) {
+        ssize_t n = read(conn->fd, buf, sizeof(buf));
+        if (n == 0) {
+            // The client may shut down its side after sending the request
+            *error = conn->request_length == 0;
+            return true;
+        } else if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *error = errno != EAGAIN && errno != EWOULDBLOCK;
+            return *error;
+        }
+        for (ssize_t i = 0; i < n; ++i) {
+            if (buf[i] == header_end[conn->header_end_matched]) {
+                conn->header_end_matched++;
+            } else {
+                conn->header_end_matched = buf[i] == '\r' ? 1 : 0;
+            }
+            if (conn->header_end_matched == 4) {
+                return true;
+            }
+        }
+        conn->request_length += n;
+        if (conn->request_length >= METRICS_MAX_REQUEST) {
+            return true;
+        }
+    }
+}
+
+static int handle_connection(int fd, uint32_t mask, void *data) {
+    struct metrics_connection *conn = data;
+
+    if (!conn->response) {
+        bool error = false;
+        if (!read_request(conn, &error)) {
+            if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) {
+                connection_destroy(conn);
+            }
+            return 0;
+        }
+        if (error || !build_response(conn)) {
+            connection_destroy(conn);
+            return 0;
+        }
+        wl_event_source_fd_update(conn->source, WL_EVENT_WRITABLE);
+    }
+
+    while (conn->written < conn->response_length) {
+        ssize_t n = send(conn->fd, conn->response + conn->written,
+            conn->response_length - conn->written, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            break;
+        }
+        conn->written += n;
+    }
+    connection_destroy(conn);
+    return 0;
+}
+
+static bool set_cloexec_nonblock(int fd) {
+    int flags = fcntl(fd, F_GETFD);
+    if (flags < 0 || fcntl(fd, F_SETFD, flags | FD_CLOEXEC) < 0) {
+        return false;
+    }
+    flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
+}
+
+static int handle_accept(int fd, uint32_t mask, void *data) {
+    for (;;) {
+        int client_fd = accept(fd, NULL, NULL);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                sway_log_errno(SWAY_ERROR, "Unable to accept metrics client");
+            }
+            return 0;
+        }
+        if (!set_cloexec_nonblock(client_fd)) {
+            close(client_fd);
+            continue;
+        }
+
+        struct metrics_connection *conn =
+            calloc(1, sizeof(struct metrics_connection));
+        if (!conn) {
+            close(client_fd);
+            continue;
+        }
+        conn->fd = client_fd;
+        conn->source = wl_event_loop_add_fd(wls->server->wl_event_loop,
+            client_fd, WL_EVENT_READABLE, handle_connection, conn);
+        if (!conn->source) {
+            close(client_fd);
+            free(conn);
+            continue;
+        }
+        wl_list_insert(&endpoint.connections, &conn->link);
+    }
+}
+
+bool wls_metrics_start(const char *path) {
+    if (endpoint.fd >= 0) {
+        return true;
+    }
+
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        sway_log(SWAY_ERROR, "Metrics socket path is too long: %s", path);
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        sway_log_errno(SWAY_ERROR, "Unable to create metrics socket");
+        return false;
+    }
+    unlink(path);
+    if (!set_cloexec_nonblock(fd) ||
+            bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+            listen(fd, 8) != 0) {
+        sway_log_errno(SWAY_ERROR, "Unable to listen on %s", path);
+        close(fd);
+        return false;
+    }
+
+    endpoint.source = wl_event_loop_add_fd(wls->server->wl_event_loop, fd,
+        WL_EVENT_READABLE, handle_accept, NULL);
+    endpoint.path = strdup(path);
+    if (!endpoint.source || !endpoint.path) {
+        sway_log(SWAY_ERROR, "Unable to serve metrics on %s", path);
+        if (endpoint.source) {
+            wl_event_source_remove(endpoint.source);
+            endpoint.source = NULL;
+        }
+        free(endpoint.path);
+        endpoint.path = NULL;
+        close(fd);
+        unlink(path);
+        return false;
+    }
+    endpoint.fd = fd;
+    wl_list_init(&endpoint.connections);
+    sway_log(SWAY_INFO, "Serving metrics on %s", path);
+    return true;
+}
+
+void wls_metrics_stop(void) {
+    if (endpoint.fd < 0) {
+        return;
+    }
+    struct metrics_connection *conn, *tmp;
+    wl_list_for_each_safe(conn, tmp, &endpoint.connections, link) {
+        connection_destroy(conn);
+    }
+    wl_event_source_remove(endpoint.source);
+    endpoint.source = NULL;
+    close(endpoint.fd);
+    endpoint.fd = -1;
+    unlink(endpoint.path);
+    free(endpoint.path);
+    endpoint.path = NULL;
+}
@@ -0,0 +1,138 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <wayland-server-core.h>
+#include "log.h"
+#include "profile.h"
+#include "server.h"
+#include "trace.h"
+#include "wlstem.h"
+
+// Number of callbacks listed by the periodic summary
+#define PROFILE_SUMMARY_TOP 5
+
+bool _wls_profile_enabled = false;
+
+static struct wl_list sites = { &sites, &sites };
+static struct wl_event_source *summary_timer = NULL;
+static uint32_t summary_interval_ms = 0;
+
+uint64_t wls_profile_begin(struct wls_profile_site *site) {
+    if (!site->registered) {
+        wl_list_insert(&sites, &site->link);
+        site->registered = true;
+    }
+    // 0 means "not measured"
+    uint64_t start = wls_trace_now();
+    return start ? start : 1;
+}
+
+void wls_profile_end(struct wls_profile_site *site, uint64_t start_ns) {
+    uint64_t end_ns = wls_trace_now();
+    if (_wls_trace_enabled) {
+        wls_trace_complete(site->name, start_ns, end_ns);
+    }
+    if (!_wls_profile_enabled) {
+        return;
+    }
+
+    uint64_t ns = end_ns - start_ns;
+    site->count++;
+    site->total_ns += ns;
+    if (ns > site->max_ns) {
+        site->max_ns = ns;
+    }
+
+    size_t i = 0;
+    while (i < WLS_PROFILE_BUCKETS - 1 && ns >= (1000ull << i)) {
+        ++i;
+    }
+    site->buckets[i]++;
+}
+
+void wls_profile_rotate(void) {
+    struct wls_profile_site *site;
+    wl_list_for_each(site, &sites, link) {
+        site->last_count = site->count - site->window_count;
+        site->last_ns = site->total_ns - site->window_ns;
+        site->window_count = site->count;
+        site->window_ns = site->total_ns;
+    }
+}
+
+size_t wls_profile_top(struct wls_profile_entry *entries, size_t max) {
+    size_t len = 0;
+    struct wls_profile_site *site;
+    wl_list_for_each(site, &sites, link) {
+        if (site->last_count == 0) {
+            continue;
+        }
+        // Insertion into the (small) sorted output array
+        size_t i = len < max ? len : max;
+        while (i > 0 && entries[i - 1].total_ns < site->last_ns) {
+            if (i < max) {
+                entries[i] = entries[i - 1];
+            }
+            --i;
+        }
+        if (i >= max) {
+            continue;
+        }
+        entries[i] = (struct wls_profile_entry){
+            .name = site->name,
+            .count = site->last_count,
+            .total_ns = site->last_ns,
+            .max_ns = site->max_ns,
+        };
+        if (len < max) {
+            ++len;
+        }
+    }
+    return len;
+}
+
+void wls_profile_reset(void) {
+    struct wls_profile_site *site, *tmp;
+    wl_list_for_each_safe(site, tmp, &sites, link) {
+        const char *name = site->name;
+        wl_list_remove(&site->link);
+        *site = (struct wls_profile_site){ .name = name };
+    }
+}
+
+static int handle_summary_timer(void *data) {
+    wls_profile_rotate();
+
+    struct wls_profile_entry top[PROFILE_SUMMARY_TOP];
+    size_t len = wls_profile_top(top, PROFILE_SUMMARY_TOP);
+    for (size_t i = 0; i < len; ++i) {
+        sway_log(SWAY_INFO, "profile: %s: %lu calls, %.3f ms total, "
+            "%.3f ms max", top[i].name, (unsigned long)top[i].count,
+            top[i].total_ns / 1e6, top[i].max_ns / 1e6);
+    }
+
+    wl_event_source_timer_update(summary_timer, summary_interval_ms);
+    return 0;
+}
+
+void wls_profile_set_enabled(bool enabled, uint32_t interval_ms) {
+    _wls_profile_enabled = enabled;
+    summary_interval_ms = enabled ? interval_ms : 0;
+
+    if (summary_interval_ms == 0) {
+        if (summary_timer) {
+            wl_event_source_remove(summary_timer);
+            summary_timer = NULL;
+        }
+        return;
+    }
+
+    if (!summary_timer) {
+        summary_timer = wl_event_loop_add_timer(wls->server->wl_event_loop,
+            handle_summary_timer, NULL);
+        if (!summary_timer) {
+            sway_log(SWAY_ERROR, "Failed to create profiler summary timer");
+            return;
+        }
+    }
+    wl_event_source_timer_update(summary_timer, summary_interval_ms);
+}
@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-util.h>
+#include "log.h"
+#include "startup.h"
+#include "trace.h"
+
+#define STARTUP_MAX_PHASES 32
+
+struct startup_phase {
+    const char *name;
+    uint64_t start_ns, end_ns;
+};
+
+struct wls_startup_job {
+    const char *name;
+    void *(*func)(void *data);
+    void *data;
+    void *result;
+    pthread_t thread;
+    bool joined;
+    uint64_t start_ns, end_ns; // written by the job's thread
+    uint64_t wait_ns;          // time the main thread spent joining it
+    struct wl_list link;       // jobs
+};
+
+struct startup_job_report {
+    const char *name;
+    uint64_t duration_ns, wait_ns;
+};
+
+static struct startup_phase phases[STARTUP_MAX_PHASES];
+static int phases_length = 0;
+// Joined jobs, which may have been freed already
+static struct startup_job_report job_reports[STARTUP_MAX_PHASES];
+static int job_reports_length = 0;
+
+static bool phase_running = false;
+static bool reported = false;
+
+// Time between exec and the first phase, 0 if unknown
+static uint64_t exec_to_first_phase_ns = 0;
+
+static struct wl_list jobs = { &jobs, &jobs };
+
+/**
+ * Return how long ago the process was started, according to the kernel. This
+ * has the resolution of the scheduler clock tick (usually 10ms).
+ */
+static uint64_t process_age_ns(void) {
+    FILE *f = fopen("/proc/self/stat", "r");
+    if (!f) {
+        return 0;
+    }
+    char buf[1024];
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[len] = '\0';
+
+    // The command name may contain anything, so skip past its last ')'.
+    // The start time is then the 20th field.
+    char *p = strrchr(buf, ')');
+    if (!p) {
+        return 0;
+    }
+    unsigned long long start_ticks = 0;
+    for (int field = 0; field < 20; ++field) {
+        p = strchr(p + 1, ' ');
+        if (!p) {
+            return 0;
+        }
+    }
+    if (sscanf(p + 1, "%llu", &start_ticks) != 1) {
+        return 0;
+    }
+    long ticks_per_sec = sysconf(_SC_CLK_TCK);
+    if (ticks_per_sec <= 0) {
+        return 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    uint64_t start_ns = start_ticks * (1000000000 / ticks_per_sec);
+    return now_ns > start_ns ? now_ns - start_ns : 0;
+}
+
+static void end_phase(uint64_t now) {
+    if (!phase_running) {
+        return;
+    }
+    struct startup_phase *phase = &phases[phases_length - 1];
+    phase->end_ns = now;
+    phase_running = false;
+    if (_wls_trace_enabled) {
+        wls_trace_complete(phase->name, phase->start_ns, phase->end_ns);
+    }
+}
+
+void wls_startup_phase(const char *name) {
+    if (reported) {
+        return;
+    }
+    uint64_t now = wls_trace_now();
+    if (phases_length == 0 && name) {
+        exec_to_first_phase_ns = process_age_ns();
+    }
+    end_phase(now);
+    if (!name) {
+        return;
+    }
+    if (phases_length == STARTUP_MAX_PHASES) {
+        sway_log(SWAY_DEBUG, "Too many startup phases, not timing '%s'", name);
+        return;
+    }
+    phases[phases_length++] = (struct startup_phase){
+        .name = name,
+        .start_ns = now,
+    };
+    phase_running = true;
+}
+
+static void *job_thread(void *data) {
+    struct wls_startup_job *job = data;
+    job->start_ns = wls_trace_now();
+    job->result = job->func(job->data);
+    job->end_ns = wls_trace_now();
+    return NULL;
+}
+
+struct wls_startup_job *wls_startup_job_start(const char *name,
+        void *(*func)(void *data), void *data) {
+    struct wls_startup_job *job = calloc(1, sizeof(struct wls_startup_job));
+    if (!job) {
+        sway_log(SWAY_ERROR, "Unable to allocate startup job");
+        return NULL;
+    }
+    job->name = name;
+    job->func = func;
+    job->data = data;
+    // Like the log writer, jobs must leave signals to the event loop
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int ret = pthread_create(&job->thread, NULL, job_thread, job);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (ret != 0) {
+        sway_log(SWAY_ERROR, "Unable to start startup job '%s': %s",
+            name, strerror(ret));
+        free(job);
+        return NULL;
+    }
+    wl_list_insert(jobs.prev, &job->link);
+    return job;
+}
+
+static void job_join(struct wls_startup_job *job) {
+    if (job->joined) {
+        return;
+    }
+    uint64_t start = wls_trace_now();
+    pthread_join(job->thread, NULL);
+    job->wait_ns = wls_trace_now() - start;
+    job->joined = true;
+    if (_wls_trace_enabled) {
+        wls_trace_complete(job->name, job->start_ns, job->end_ns);
+    }
+    if (!reported && job_reports_length < STARTUP_MAX_PHASES) {
+        job_reports[job_reports_length++] = (struct startup_job_report){
+            .name = job->name,
+            .duration_ns = job->end_ns - job->start_ns,
+            .wait_ns = job->wait_ns,
+        };
+    }
+}
+
+void *wls_startup_job_take(struct wls_startup_job *job) {
+    job_join(job);
+    void *result = job->result;
+    wl_list_remove(&job->link);
+    free(job);
+    return result;
+}
+
+void wls_startup_wait_jobs(void) {
+    struct wls_startup_job *job;
+    wl_list_for_each(job, &jobs, link) {
+        job_join(job);
+    }
+}
+
+void wls_startup_first_frame(void) {
+    if (reported || phases_length == 0) {
+        return;
+    }
+    uint64_t now = wls_trace_now();
+    end_phase(now);
+    reported = true;
+
+    uint64_t total_ns = exec_to_first_phase_ns + (now - phases[0].start_ns);
+    sway_log(SWAY_INFO, "Startup took %.1f ms from exec to the first frame",
+        total_ns / 1e6);
+    if (exec_to_first_phase_ns) {
+        sway_log(SWAY_INFO, "  %-24s %8.1f ms", "exec",
+            exec_to_first_phase_ns / 1e6);
+    }
+    for (int i = 0; i < phases_length; ++i) {
+        sway_log(SWAY_INFO, "  %-24s %8.1f ms", phases[i].name,
+            (phases[i].end_ns - phases[i].start_ns) / 1e6);
+    }
+    for (int i = 0; i < job_reports_length; ++i) {
+        sway_log(SWAY_INFO, "  %-24s %8.1f ms in the background, "
+            "waited %.1f ms", job_reports[i].name,
+            job_reports[i].duration_ns / 1e6, job_reports[i].wait_ns / 1e6);
+    }
+}
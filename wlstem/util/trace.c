@@ -0,0 +1,133 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "log.h"
+#include "trace.h"
+
+#define TRACE_BUFFER_SIZE 65536
+
+bool _wls_trace_enabled = false;
+
+static struct {
+    int fd;
+    pid_t pid;
+    bool first;
+    size_t len;
+    char buffer[TRACE_BUFFER_SIZE];
+} trace = { .fd = -1 };
+
+uint64_t wls_trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void trace_flush(void) {
+    size_t written = 0;
+    while (written < trace.len) {
+        ssize_t n = write(trace.fd, trace.buffer + written,
+            trace.len - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            sway_log_errno(SWAY_ERROR, "Failed to write trace, stopping");
+            trace.len = 0;
+            _wls_trace_enabled = false;
+            return;
+        }
+        written += n;
+    }
+    trace.len = 0;
+}
+
+static void trace_append(const char *fmt, ...) ATTRIB_PRINTF(1, 2);
+
+static void trace_append(const char *fmt, ...) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(trace.buffer + trace.len,
+            TRACE_BUFFER_SIZE - trace.len, fmt, args);
+        va_end(args);
+        if (n >= 0 && (size_t)n < TRACE_BUFFER_SIZE - trace.len) {
+            trace.len += n;
+            return;
+        }
+        // Didn't fit, make some room and try again
+        trace_flush();
+    }
+}
+
+void wls_trace_complete(const char *name, uint64_t start_ns, uint64_t end_ns) {
+    if (trace.fd < 0) {
+        return;
+    }
+    trace_append("%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+        "\"pid\":%d,\"tid\":%d}", trace.first ? "" : ",\n", name,
+        start_ns / 1e3, (end_ns - start_ns) / 1e3, trace.pid, trace.pid);
+    trace.first = false;
+}
+
+static bool trace_start_fd(int fd) {
+    trace.fd = fd;
+    trace.pid = getpid();
+    trace.first = true;
+    trace.len = 0;
+    trace_append("[\n");
+    _wls_trace_enabled = true;
+    return true;
+}
+
+bool wls_trace_start_file(const char *path) {
+    if (trace.fd >= 0) {
+        return true;
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        sway_log_errno(SWAY_ERROR, "Unable to open trace file '%s'", path);
+        return false;
+    }
+    sway_log(SWAY_INFO, "Writing trace to '%s'", path);
+    return trace_start_fd(fd);
+}
+
+int wls_trace_start_memfd(void) {
+    if (trace.fd >= 0) {
+        return -1;
+    }
+    int fd = memfd_create("wlstem-trace", MFD_CLOEXEC);
+    if (fd < 0) {
+        sway_log_errno(SWAY_ERROR, "Unable to create trace memfd");
+        return -1;
+    }
+    int user_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (user_fd < 0) {
+        sway_log_errno(SWAY_ERROR, "Unable to duplicate trace memfd");
+        close(fd);
+        return -1;
+    }
+    trace_start_fd(fd);
+    return user_fd;
+}
+
+bool wls_trace_active(void) {
+    return trace.fd >= 0;
+}
+
+void wls_trace_stop(void) {
+    if (trace.fd < 0) {
+        return;
+    }
+    _wls_trace_enabled = false;
+    trace_append("\n]\n");
+    trace_flush();
+    close(trace.fd);
+    trace.fd = -1;
+}
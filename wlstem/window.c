@@ -23,8 +23,6 @@ struct wls_window *window_create(struct sway_view *view) {
     win->view = view;
     win->alpha = 1.0f;
 
-    win->outputs = create_list();
-
     wl_signal_init(&win->events.destroy);
     wl_signal_init(&win->events.scale_change);
     wl_signal_emit(&wls->node_manager->events.new_node, &win->node);
@@ -45,7 +43,7 @@ void window_destroy(struct wls_window *win) {
         return;
     }
     free(win->title);
-    list_free(win->outputs);
+    wls_output_vec_finish(&win->outputs);
 
     if (win->view) {
         if (win->view->window == win) {
@@ -76,6 +74,7 @@ void window_detach(struct wls_window *child) {
     child->output = NULL;
 
     if (old_output) {
+        old_output->changes |= WLS_OUTPUT_CHANGED_WINDOWS;
         node_set_dirty(&old_output->node);
     }
     node_set_dirty(&child->node);
@@ -140,10 +139,10 @@ void window_replace(struct wls_window *window,
  * This is the most recently entered output.
  */
 struct sway_output *window_get_effective_output(struct wls_window *win) {
-    if (win->outputs->length == 0) {
+    if (win->outputs.length == 0) {
         return NULL;
     }
-    return win->outputs->items[win->outputs->length - 1];
+    return win->outputs.items[win->outputs.length - 1];
 }
 
 static void surface_send_enter_iterator(struct wlr_surface *surface,
@@ -167,14 +166,14 @@ void window_discover_outputs(struct wls_window *win) {
     };
     struct sway_output *old_output = window_get_effective_output(win);
 
-    for (int i = 0; i < wls->output_manager->outputs->length; ++i) {
-        struct sway_output *output = wls->output_manager->outputs->items[i];
+    for (int i = 0; i < wls->output_manager->outputs.length; ++i) {
+        struct sway_output *output = wls->output_manager->outputs.items[i];
         struct wlr_box output_box;
         output_get_box(output, &output_box);
         struct wlr_box intersection;
         bool intersects =
             wlr_box_intersection(&intersection, &con_box, &output_box);
-        int index = list_find(win->outputs, output);
+        int index = wls_output_vec_find(&win->outputs, output);
 
         if (intersects && index == -1) {
             // Send enter
@@ -187,7 +186,7 @@ void window_discover_outputs(struct wls_window *win) {
                             win->view->foreign_toplevel, output->wlr_output);
                 }
             }
-            list_add(win->outputs, output);
+            wls_output_vec_push(&win->outputs, output);
         } else if (!intersects && index != -1) {
             // Send leave
             sway_log(SWAY_DEBUG, "Window %p left output %p", win, output);
@@ -199,7 +198,8 @@ void window_discover_outputs(struct wls_window *win) {
                             win->view->foreign_toplevel, output->wlr_output);
                 }
             }
-            list_del(win->outputs, index);
+            // Keep the order, the last output is the effective one
+            wls_output_vec_remove(&win->outputs, index);
         }
     }
     struct sway_output *new_output = window_get_effective_output(win);
@@ -2,15 +2,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <wayland-server-core.h>
+#include "exec.h"
 #include "input_method.h"
 #include "list.h"
 #include "log.h"
+#include "metrics.h"
 #include "misc_protocols.h"
 #include "node.h"
 #include "output_config.h"
 #include "output_manager.h"
+#include "profile.h"
 #include "server.h"
+#include "trace.h"
 #include "wlstem.h"
+#include "xcursor_cache.h"
 
 struct wls_context *wls = NULL;
 
@@ -47,6 +52,8 @@ bool wls_init(const struct wls_user_callbacks *callbacks) {
         _server->wl_display);
 
     wl_list_init(&_wls->seats);
+    wl_list_init(&_wls->xcursor_themes);
+    wls_metrics_init(&_wls->metrics);
 
     struct wls_misc_protocols *_misc_protocols =
         wls_create_misc_protocols(_server->wl_display);
@@ -63,6 +70,8 @@ bool wls_init(const struct wls_user_callbacks *callbacks) {
     wls->node_manager = _node_manager;
     wls->output_manager = _output_manager;
     wls->output_configs = _output_configs;
+    // Outputs start with generation 0, so that they look their config up
+    wls->output_configs_generation = 1;
     wls->input_method_manager = _input_method_manager;
     wls->tablet_v2 = _tablet_v2;
     wls->misc_protocols = _misc_protocols;
@@ -78,9 +87,16 @@ void wls_fini(void) {
         return; // nothing to do.
     }
 
+    wls_profile_set_enabled(false, 0);
+    wls_spawn_fini();
+    wls_trace_stop();
+    wls_xcursor_cache_finish();
+    wls_metrics_stop();
+
     // This needs the output_manager and the the dirty_nodes list,
     // so call it before destroying them
     wls_server_destroy(wls->server);
+    wls_metrics_finish(&wls->metrics);
 
     wls_output_manager_destroy(wls->output_manager);
     if (wls->output_configs) {